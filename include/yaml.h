@@ -313,6 +313,11 @@ typedef struct yaml_token_s {
             size_t length;
             /** The scalar style. */
             yaml_scalar_style_t style;
+            /**
+             * Does the value point into the input (see
+             * yaml_parser_set_zero_copy())?
+             */
+            int borrowed;
         } scalar;
 
         /** The version directive (for @c YAML_VERSION_DIRECTIVE_TOKEN). */
@@ -338,6 +343,12 @@ typedef struct yaml_token_s {
     /** The end of the token. */
     yaml_mark_t end_mark;
 
+    /**
+     * Are the strings of the token owned by the parser arena (see
+     * yaml_parser_set_arena())?
+     */
+    int arena;
+
 } yaml_token_t;
 
 /**
@@ -447,6 +458,11 @@ typedef struct yaml_event_s {
             int quoted_implicit;
             /** The scalar style. */
             yaml_scalar_style_t style;
+            /**
+             * Does the value point into the input (see
+             * yaml_parser_set_zero_copy())?
+             */
+            int borrowed;
         } scalar;
 
         /** The sequence parameters (for @c YAML_SEQUENCE_START_EVENT). */
@@ -480,6 +496,12 @@ typedef struct yaml_event_s {
     /** The end of the event. */
     yaml_mark_t end_mark;
 
+    /**
+     * Are the strings of the event owned by the parser arena (see
+     * yaml_parser_set_arena())?
+     */
+    int arena;
+
 } yaml_event_t;
 
 /**
@@ -770,6 +792,17 @@ struct yaml_node_s {
             } pairs;
             /** The mapping style. */
             yaml_mapping_style_t style;
+            /**
+             * The hash table of the scalar keys: the positions of their pairs
+             * in the stack plus one, or @c 0 for empty slots (see
+             * yaml_document_mapping_get()).
+             */
+            struct {
+                /** The beginning of the table. */
+                int *start;
+                /** The end of the table. */
+                int *end;
+            } index;
         } mapping;
 
     } data;
@@ -815,8 +848,108 @@ typedef struct yaml_document_s {
     /** The end of the document. */
     yaml_mark_t end_mark;
 
+    /**
+     * The arena of the tags, values, items, pairs and directives of the
+     * nodes, or @c NULL if they are allocated one by one (see
+     * yaml_parser_set_document_arena()).
+     */
+    struct yaml_arena_s *arena;
+
 } yaml_document_t;
 
+/**
+ * The compact document structure.
+ *
+ * The nodes are stored in parallel arrays indexed by the node id minus one,
+ * the root node having the id @c 1.  The scalar values and the tags are kept
+ * in a single block of strings, and the children of all collections in a
+ * single array of node ids.  The marks of the nodes are optional.  Use the
+ * yaml_compact_node_*() functions to access the nodes.
+ */
+
+typedef struct yaml_compact_document_s {
+
+    /** The number of nodes. */
+    int count;
+    /** The allocated size of the node arrays. */
+    int capacity;
+    /** Are the marks of the nodes kept? */
+    int marks;
+
+    /** The types of the nodes (@c yaml_node_type_t). */
+    unsigned char *types;
+    /** The styles of the nodes. */
+    unsigned char *styles;
+    /** The ids of the tags of the nodes: their positions in the tag list. */
+    int *tags;
+    /**
+     * The offsets of the scalar values in the strings, or of the first
+     * children of the collections in the children array.
+     */
+    size_t *offsets;
+    /** The lengths of the scalar values, or the numbers of children. */
+    size_t *lengths;
+    /** The beginnings of the nodes, or @c NULL if the marks are not kept. */
+    yaml_mark_t *start_marks;
+    /** The ends of the nodes, or @c NULL if the marks are not kept. */
+    yaml_mark_t *end_marks;
+
+    /**
+     * The children of the collections: the items of the sequences, and the
+     * keys and the values of the mappings in turn.
+     */
+    struct {
+        /** The beginning of the array. */
+        int *start;
+        /** The end of the array. */
+        int *end;
+        /** The top of the array. */
+        int *top;
+    } children;
+
+    /** The scalar values and the tags, each followed by a NUL character. */
+    struct {
+        /** The beginning of the block. */
+        yaml_char_t *start;
+        /** The end of the block. */
+        yaml_char_t *end;
+        /** The end of the used part of the block. */
+        yaml_char_t *pointer;
+    } strings;
+
+    /** The tag list: the offsets of the distinct tags in the strings. */
+    struct {
+        /** The beginning of the list. */
+        size_t *start;
+        /** The end of the list. */
+        size_t *end;
+        /** The top of the list. */
+        size_t *top;
+    } tag_list;
+
+    /** The version directive. */
+    yaml_version_directive_t *version_directive;
+
+    /** The list of tag directives. */
+    struct {
+        /** The beginning of the tag directives list. */
+        yaml_tag_directive_t *start;
+        /** The end of the tag directives list. */
+        yaml_tag_directive_t *end;
+    } tag_directives;
+
+    /** Is the document start indicator implicit? */
+    int start_implicit;
+    /** Is the document end indicator implicit? */
+    int end_implicit;
+
+    /** The beginning of the document. */
+    yaml_mark_t start_mark;
+    /** The end of the document. */
+    yaml_mark_t end_mark;
+
+} yaml_compact_document_t;
+
 /**
  * Create a YAML document.
  *
@@ -965,6 +1098,137 @@ YAML_DECLARE(int)
 yaml_document_append_mapping_pair(yaml_document_t *document,
         int mapping, int key, int value);
 
+/**
+ * Find the value of a scalar key in a MAPPING node.
+ *
+ * The keys are compared by their values; tags and styles are ignored.  If
+ * the key occurs several times, the first pair is used.  The first lookup
+ * in a mapping of many pairs builds a hash table of its keys, which is kept
+ * in the node and updated by yaml_document_append_mapping_pair().  The pairs
+ * must not be changed in other ways once the mapping is indexed.
+ *
+ * @param[in,out]   document    A document object.
+ * @param[in]       mapping     The mapping node id.
+ * @param[in]       key         The key value.
+ * @param[in]       length      The length of the key or @c -1 if it is
+ *                              @c NULL terminated.
+ *
+ * @returns the value node or @c NULL if the key is not found.
+ */
+
+YAML_DECLARE(yaml_node_t *)
+yaml_document_mapping_get(yaml_document_t *document,
+        int mapping, const yaml_char_t *key, int length);
+
+/**
+ * Build the hash tables of the keys of all MAPPING nodes of a document.
+ *
+ * The function may be called after yaml_parser_load() to index the document
+ * up front instead of on the first lookup in each mapping (see
+ * yaml_document_mapping_get()).  Small mappings are not indexed.
+ *
+ * @param[in,out]   document    A document object.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_document_build_indexes(yaml_document_t *document);
+
+/**
+ * Delete a compact document and all its nodes.
+ *
+ * @param[in,out]   document    A compact document object.
+ */
+
+YAML_DECLARE(void)
+yaml_compact_document_delete(yaml_compact_document_t *document);
+
+/**
+ * Get the type of a node of a compact document.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ *
+ * @returns the node type.
+ */
+
+YAML_DECLARE(yaml_node_type_t)
+yaml_compact_node_type(yaml_compact_document_t *document, int node);
+
+/**
+ * Get the tag of a node of a compact document.
+ *
+ * The tags are interned, so the nodes of the same tag share the pointer.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ *
+ * @returns the node tag.
+ */
+
+YAML_DECLARE(const yaml_char_t *)
+yaml_compact_node_tag(yaml_compact_document_t *document, int node);
+
+/**
+ * Get the style of a node of a compact document.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ *
+ * @returns the scalar, sequence or mapping style of the node.
+ */
+
+YAML_DECLARE(int)
+yaml_compact_node_style(yaml_compact_document_t *document, int node);
+
+/**
+ * Get the value of a SCALAR node of a compact document.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ * @param[out]      length      The length of the value, if not @c NULL.
+ *
+ * @returns the @c NULL terminated value, or @c NULL if the node is not a
+ * scalar.
+ */
+
+YAML_DECLARE(const yaml_char_t *)
+yaml_compact_node_value(yaml_compact_document_t *document, int node,
+        size_t *length);
+
+/**
+ * Get the children of a SEQUENCE or MAPPING node of a compact document.
+ *
+ * The children of a sequence are its items; the children of a mapping are
+ * the key and the value of each pair in turn.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ * @param[out]      count       The number of children.
+ *
+ * @returns the array of the child ids, or @c NULL if there are none.
+ */
+
+YAML_DECLARE(const int *)
+yaml_compact_node_children(yaml_compact_document_t *document, int node,
+        int *count);
+
+/**
+ * Get the marks of a node of a compact document.
+ *
+ * @param[in]       document    A compact document object.
+ * @param[in]       node        The node id.
+ * @param[out]      start_mark  The beginning of the node.
+ * @param[out]      end_mark    The end of the node.
+ *
+ * @returns @c 1 if the marks are kept, @c 0 otherwise.
+ */
+
+YAML_DECLARE(int)
+yaml_compact_node_marks(yaml_compact_document_t *document, int node,
+        yaml_mark_t *start_mark, yaml_mark_t *end_mark);
+
 /** @} */
 
 /**
@@ -1011,6 +1275,18 @@ typedef struct yaml_simple_key_s {
     yaml_mark_t mark;
 } yaml_simple_key_t;
 
+/**
+ * This structure holds a token waiting to be inserted into the tokens queue.
+ */
+
+typedef struct yaml_pending_token_s {
+    /** The number of the token. */
+    size_t token_number;
+
+    /** The token. */
+    yaml_token_t token;
+} yaml_pending_token_t;
+
 /**
  * The states of the parser.
  */
@@ -1136,6 +1412,26 @@ typedef struct yaml_parser_s {
 
         /** File input data. */
         FILE *file;
+
+        /** Pushed input data (see yaml_parser_feed()). */
+        struct {
+            /** The beginning of the buffer. */
+            unsigned char *start;
+            /** The end of the buffer. */
+            unsigned char *end;
+            /** The current position of the buffer. */
+            unsigned char *pointer;
+            /** The last filled position of the buffer. */
+            unsigned char *last;
+            /** Is the end of the input fed? */
+            int final;
+            /**
+             * The position in the working buffer the scanner returns to if
+             * the input runs out in the middle of a token, or @c NULL if
+             * no token fetch is in progress.
+             */
+            yaml_char_t *checkpoint;
+        } feed;
     } input;
 
     /** EOF flag */
@@ -1156,6 +1452,33 @@ typedef struct yaml_parser_s {
     /* The number of unread characters in the buffer. */
     size_t unread;
 
+    /** The number of characters put into the buffer. */
+    size_t decoded;
+
+    /**
+     * The memory allocated for the working buffer while the working buffer
+     * points directly into a string input.
+     */
+    struct {
+        /** The beginning of the storage. */
+        yaml_char_t *start;
+        /** The end of the storage. */
+        yaml_char_t *end;
+    } buffer_storage;
+
+    /** The memory-mapped input file. */
+    struct {
+        /** The beginning of the mapping. */
+        void *start;
+        /** The size of the mapping. */
+        size_t size;
+        /** The beginning of the pages that are not released yet. */
+        const unsigned char *resident;
+    } mapping;
+
+    /** The read-ahead thread (see yaml_parser_set_read_ahead()). */
+    struct yaml_read_ahead_s *read_ahead;
+
     /** The raw buffer. */
     struct {
         /** The beginning of the buffer. */
@@ -1174,9 +1497,17 @@ typedef struct yaml_parser_s {
     /** The offset of the current position (in bytes). */
     size_t offset;
 
-    /** The mark of the current position. */
+    /**
+     * The mark of the current position.
+     *
+     * The scanner derives the index and the column from the number of the
+     * unread characters and updates them only when it needs them.
+     */
     yaml_mark_t mark;
 
+    /** The index of the first character of the current line. */
+    size_t line_start;
+
     /**
      * @}
      */
@@ -1195,6 +1526,25 @@ typedef struct yaml_parser_s {
     /** The number of unclosed '[' and '{' indicators. */
     int flow_level;
 
+    /** May scalars point into the input (see yaml_parser_set_zero_copy())? */
+    int zero_copy;
+
+    /**
+     * Is the JSON tokenizer used in all flow collections (@c 1), never
+     * (@c -1), or in a flow collection that is the root node of a document
+     * (@c 0, see yaml_parser_set_json_mode())?
+     */
+    int json_mode;
+
+    /** Is the outermost flow collection the root node of a document? */
+    int json_root;
+
+    /**
+     * The arena of the token and event strings, or @c NULL if they are
+     * allocated one by one (see yaml_parser_set_arena()).
+     */
+    struct yaml_arena_s *arena;
+
     /** The tokens queue. */
     struct {
         /** The beginning of the tokens queue. */
@@ -1207,11 +1557,26 @@ typedef struct yaml_parser_s {
         yaml_token_t *tail;
     } tokens;
 
+    /**
+     * The KEY and BLOCK-MAPPING-START tokens found after the tokens they
+     * precede, in the order of their numbers.
+     */
+    struct {
+        /** The beginning of the pending tokens queue. */
+        yaml_pending_token_t *start;
+        /** The end of the pending tokens queue. */
+        yaml_pending_token_t *end;
+        /** The head of the pending tokens queue. */
+        yaml_pending_token_t *head;
+        /** The tail of the pending tokens queue. */
+        yaml_pending_token_t *tail;
+    } pending_tokens;
+
     /** The number of tokens fetched from the queue. */
     size_t tokens_parsed;
 
-    /* Does the tokens queue contain a token ready for dequeueing. */
-    int token_available;
+    /** The number of tokens at the head of the queue ready for dequeueing. */
+    size_t token_available;
 
     /** The indentation levels stack. */
     struct {
@@ -1239,6 +1604,27 @@ typedef struct yaml_parser_s {
         yaml_simple_key_t *top;
     } simple_keys;
 
+    /**
+     * The index of the lowest potential simple key that may still be
+     * possible.  The keys below it are not.
+     */
+    size_t simple_keys_lowest;
+
+    /**
+     * The scratch strings of the scalar scanners: the value, the leading line
+     * break, the trailing line breaks and the whitespaces.  They are reused
+     * from scalar to scalar; only the final value is allocated for a token.
+     */
+    struct {
+        /** The beginning of the string. */
+        yaml_char_t *start;
+        /** The end of the string. */
+        yaml_char_t *end;
+        /** The current position of the string. */
+        yaml_char_t *pointer;
+    } scratch_string, scratch_leading_break, scratch_trailing_breaks,
+        scratch_whitespaces;
+
     /**
      * @}
      */
@@ -1300,9 +1686,58 @@ typedef struct yaml_parser_s {
         yaml_alias_data_t *top;
     } aliases;
 
+    /**
+     * The hash table of the anchors: the positions of their alias data in the
+     * list plus one, or @c 0 for empty slots.
+     */
+    struct {
+        /** The beginning of the table. */
+        size_t *start;
+        /** The end of the table. */
+        size_t *end;
+    } anchors;
+
     /** The currently parsed document. */
     yaml_document_t *document;
 
+    /**
+     * The size of a chunk of the document arenas, or @c 0 if the documents
+     * are allocated one block at a time (see
+     * yaml_parser_set_document_arena()).
+     */
+    size_t document_arena;
+
+    /** The items of the open sequences of an arena or compact document. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_node_item_t *start;
+        /** The end of the stack. */
+        yaml_node_item_t *end;
+        /** The top of the stack. */
+        yaml_node_item_t *top;
+    } items;
+
+    /** The pairs of the open mappings of an arena document. */
+    struct {
+        /** The beginning of the stack. */
+        yaml_node_pair_t *start;
+        /** The end of the stack. */
+        yaml_node_pair_t *end;
+        /** The top of the stack. */
+        yaml_node_pair_t *top;
+    } pairs;
+
+    /**
+     * The hash table of the tags of a compact document: their ids plus one,
+     * or @c 0 for empty slots.
+     */
+    struct {
+        /** The beginning of the table. */
+        int *start;
+        /** The end of the table. */
+        int *end;
+    } tag_index;
+
     /**
      * @}
      */
@@ -1339,6 +1774,8 @@ yaml_parser_delete(yaml_parser_t *parser);
  * exists.  The application is responsible for destroing @a input after
  * destroying the @a parser.
  *
+ * A valid UTF-8 input is not copied: the parser scans it in place.
+ *
  * @param[in,out]   parser  A parser object.
  * @param[in]       input   A source data.
  * @param[in]       size    The length of the source data in bytes.
@@ -1361,6 +1798,53 @@ yaml_parser_set_input_string(yaml_parser_t *parser,
 YAML_DECLARE(void)
 yaml_parser_set_input_file(yaml_parser_t *parser, FILE *file);
 
+/**
+ * Set a memory-mapped file input.
+ *
+ * The file is mapped into memory and scanned in place; the pages behind the
+ * scanned position are released as the parsing goes, so huge files do not
+ * stay resident.  @a fd should be a regular file open for reading.  The
+ * application may close @a fd once the function returns; the mapping is
+ * released by yaml_parser_delete().
+ *
+ * Memory-mapped files are not supported on every platform.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       fd      An open file descriptor.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_set_input_mmap(yaml_parser_t *parser, int fd);
+
+/**
+ * Feed a chunk of a pushed input.
+ *
+ * Instead of pulling the input through a read handler, the application may
+ * push it in chunks as it arrives.  The first call turns the parser into the
+ * push mode; no input may be set for the parser otherwise.  The data is
+ * copied, so the application may reuse @a data once the function returns.
+ *
+ * When yaml_parser_parse() or yaml_parser_scan() runs out of the fed input, it
+ * returns @c YAML_PARSER_NEED_MORE_INPUT and resumes from the same point on
+ * the next call after more input is fed.  The tokens and events produced are
+ * the same as for a pulled input.  A token cut by the end of the fed input
+ * is scanned again from its beginning, so very long scalars are better fed in
+ * large chunks.  yaml_parser_load() does not support pushed input.
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[in]       data        A chunk of the input.
+ * @param[in]       size        The size of the chunk in bytes.
+ * @param[in]       is_final    Set if the chunk ends the input.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_feed(yaml_parser_t *parser,
+        const unsigned char *data, size_t size, int is_final);
+
 /**
  * Set a generic input handler.
  *
@@ -1374,6 +1858,28 @@ YAML_DECLARE(void)
 yaml_parser_set_input(yaml_parser_t *parser,
         yaml_read_handler_t *handler, void *data);
 
+/**
+ * Read a file or generic input ahead in a background thread.
+ *
+ * A helper thread calls the read handler to keep up to @a count chunks of
+ * @a size bytes filled, so the input is read while the parser decodes and
+ * scans the previous chunks.  The function must be called after the input is
+ * set and before the parsing is started.  The read handler is called from the
+ * helper thread, and yaml_parser_delete() waits for its last call to return.
+ *
+ * If the library is built without thread support, the input is read as
+ * usual.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       count   The number of chunks, or @c 0 for the default.
+ * @param[in]       size    The size of a chunk, or @c 0 for the default.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_set_read_ahead(yaml_parser_t *parser, size_t count, size_t size);
+
 /**
  * Set the source encoding.
  *
@@ -1384,6 +1890,111 @@ yaml_parser_set_input(yaml_parser_t *parser,
 YAML_DECLARE(void)
 yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding);
 
+/**
+ * Let scalar tokens and events point into the input instead of copies.
+ *
+ * With a valid UTF-8 string input or a memory-mapped input, the value of a
+ * scalar that is a verbatim slice of the input (a plain scalar on a single
+ * line, or a quoted scalar without escapes and line breaks) is not copied.
+ * Its @c borrowed flag is set, and its value is not terminated by NUL: use
+ * the @c length field.  A borrowed value stays valid as long as the input
+ * string or, for a memory-mapped input, the parser.  yaml_token_delete() and
+ * yaml_event_delete() do not free it, and yaml_parser_load() copies it.
+ *
+ * Other inputs and other scalars are not affected.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       enabled @c 1 to enable borrowed values, @c 0 to disable
+ *                          them.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_zero_copy(yaml_parser_t *parser, int enabled);
+
+/**
+ * Set whether the JSON tokenizer is used for the content of flow collections.
+ *
+ * The JSON tokenizer fetches the ':' after a double-quoted key together with
+ * the key, and copies a plain scalar that ends at ',', ']' or '}' (a number,
+ * @c true, @c false or @c null) at once.  Anything else is scanned as usual,
+ * so the tokens, the events and the errors are the same for any input, JSON
+ * or not; the JSON tokenizer is only faster on JSON.
+ *
+ * By default, the JSON tokenizer is used in a flow collection that is the root
+ * node of a document, as a JSON text is.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       enabled @c 1 to use the JSON tokenizer in all flow
+ *                          collections, @c 0 to never use it.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_json_mode(yaml_parser_t *parser, int enabled);
+
+/**
+ * Allocate the strings of tokens and events from an arena.
+ *
+ * The anchors, tags, scalar values and directives of the produced tokens and
+ * events are bump-allocated in chunks owned by the parser instead of one by
+ * one.  They stay valid until the next call of yaml_parser_parse(),
+ * yaml_parser_parse_batch() or yaml_parser_scan(), or until
+ * yaml_parser_release_arena() is called.  The @c arena flag of the tokens and
+ * events is set, and yaml_token_delete() and yaml_event_delete() free
+ * nothing.
+ *
+ * Since the emitter may keep events until it is given the following ones,
+ * the events cannot be passed to yaml_emitter_emit().  yaml_parser_load()
+ * supports the arena only if the documents are loaded into arenas too (see
+ * yaml_parser_set_document_arena()).  The function must be called before the
+ * parsing is started.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       size    The size of a chunk, or @c 0 for the default.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_set_arena(yaml_parser_t *parser, size_t size);
+
+/**
+ * Release the strings of the tokens and events produced so far.
+ *
+ * The chunks of the arena are kept for reuse.  Nothing is done if the arena
+ * is not enabled (see yaml_parser_set_arena()).
+ *
+ * @param[in,out]   parser  A parser object.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_release_arena(yaml_parser_t *parser);
+
+/**
+ * Load the documents into arenas.
+ *
+ * The tags and values of the nodes, the items of the sequences, the pairs of
+ * the mappings and the directives of a document produced by
+ * yaml_parser_load() are bump-allocated in chunks owned by the document, and
+ * the items and pairs of a collection are stored in a single block of the
+ * exact size.  yaml_document_delete() frees the chunks and the array of the
+ * nodes instead of every block.  The nodes may be added and extended with
+ * the yaml_document_add_*() and yaml_document_append_*() functions as usual;
+ * the replaced blocks stay in the arena until the document is deleted.
+ *
+ * @param[in,out]   parser  A parser object.
+ * @param[in]       size    The size of a chunk, or @c 0 for the default.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_document_arena(yaml_parser_t *parser, size_t size);
+
+/**
+ * The value returned by yaml_parser_parse() and yaml_parser_scan() when a
+ * pushed input runs out (see yaml_parser_feed()).
+ */
+
+#define YAML_PARSER_NEED_MORE_INPUT 2
+
 /**
  * Scan the input stream and produce the next token.
  *
@@ -1402,7 +2013,8 @@ yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding);
  * @param[in,out]   parser      A parser object.
  * @param[out]      token       An empty token object.
  *
- * @returns @c 1 if the function succeeded, @c 0 on error.
+ * @returns @c 1 if the function succeeded, @c 0 on error, or
+ * @c YAML_PARSER_NEED_MORE_INPUT if a pushed input runs out.
  */
 
 YAML_DECLARE(int)
@@ -1426,12 +2038,40 @@ yaml_parser_scan(yaml_parser_t *parser, yaml_token_t *token);
  * @param[in,out]   parser      A parser object.
  * @param[out]      event       An empty event object.
  *
- * @returns @c 1 if the function succeeded, @c 0 on error.
+ * @returns @c 1 if the function succeeded, @c 0 on error, or
+ * @c YAML_PARSER_NEED_MORE_INPUT if a pushed input runs out.
  */
 
 YAML_DECLARE(int)
 yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event);
 
+/**
+ * Parse the input stream and produce the next parsing events at once.
+ *
+ * The function fills the array @a events with up to @a max events, as many
+ * subsequent calls of yaml_parser_parse() would, and stores their number in
+ * @a count.  It stops early after the @c YAML_STREAM_END_EVENT event, or
+ * after a @c YAML_DOCUMENT_END_EVENT event if @a document is set.  No events
+ * are produced after the end of the stream.
+ *
+ * The produced events are valid even if the function fails, and an
+ * application is responsible for freeing each of them using the
+ * yaml_event_delete() function.
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[out]      events      An array of at least @a max event objects.
+ * @param[in]       max         The size of the array.
+ * @param[out]      count       The number of produced events.
+ * @param[in]       document    Set to stop at the end of a document.
+ *
+ * @returns @c 1 if the function succeeded, @c 0 on error, or
+ * @c YAML_PARSER_NEED_MORE_INPUT if a pushed input runs out.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_parse_batch(yaml_parser_t *parser, yaml_event_t *events,
+        size_t max, size_t *count, int document);
+
 /**
  * Parse the input stream and produce the next YAML document.
  *
@@ -1457,6 +2097,27 @@ yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event);
 YAML_DECLARE(int)
 yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document);
 
+/**
+ * Parse the input stream and produce the next YAML document in the compact
+ * form.
+ *
+ * The function works like yaml_parser_load().  The produced document has no
+ * nodes if the stream end has been reached.  An application is responsible
+ * for freeing the document using the yaml_compact_document_delete()
+ * function.  The parser arena (see yaml_parser_set_arena()) is not
+ * supported.
+ *
+ * @param[in,out]   parser      A parser object.
+ * @param[out]      document    An empty compact document object.
+ * @param[in]       marks       Whether the marks of the nodes are kept.
+ *
+ * @return @c 1 if the function succeeded, @c 0 on error.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_load_compact(yaml_parser_t *parser,
+        yaml_compact_document_t *document, int marks);
+
 /** @} */
 
 /**
@@ -1,6 +1,19 @@
 
 #include "yaml_private.h"
 
+#if HAVE_PTHREAD_H
+static void
+yaml_parser_stop_read_ahead(yaml_parser_t *parser);
+#endif
+
+static int *
+yaml_document_find_key(yaml_document_t *document, yaml_node_t *mapping,
+        const yaml_char_t *key, size_t length);
+
+static void
+yaml_document_index_pair(yaml_document_t *document, yaml_node_t *mapping,
+        int position);
+
 /*
  * Get the library version.
  */
@@ -23,6 +36,46 @@ yaml_get_version(int *major, int *minor, int *patch)
     *patch = YAML_VERSION_PATCH;
 }
 
+/*
+ * The character classes of the octets (see YAML_CHAR_ALPHA and the other
+ * class bits in yaml_private.h).
+ */
+
+const unsigned short yaml_char_classes[256] = {
+    0x040, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 00 */
+    0x000, 0x010, 0x120, 0x000, 0x000, 0x020, 0x000, 0x000,  /* 08 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 10 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 18 */
+    0x108, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,  /* 20 */
+    0x100, 0x100, 0x100, 0x100, 0x500, 0x101, 0x100, 0x100,  /* 28 */
+    0x107, 0x107, 0x107, 0x107, 0x107, 0x107, 0x107, 0x107,  /* 30 */
+    0x107, 0x107, 0x100, 0x100, 0x100, 0x100, 0x100, 0x500,  /* 38 */
+    0x100, 0x105, 0x105, 0x105, 0x105, 0x105, 0x105, 0x101,  /* 40 */
+    0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101,  /* 48 */
+    0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101,  /* 50 */
+    0x101, 0x101, 0x101, 0x500, 0x100, 0x500, 0x100, 0x101,  /* 58 */
+    0x100, 0x105, 0x105, 0x105, 0x105, 0x105, 0x105, 0x101,  /* 60 */
+    0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101,  /* 68 */
+    0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101, 0x101,  /* 70 */
+    0x101, 0x101, 0x101, 0x500, 0x100, 0x500, 0x100, 0x000,  /* 78 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 80 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 88 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 90 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* 98 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* A0 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* A8 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* B0 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* B8 */
+    0x000, 0x000, 0x280, 0x100, 0x100, 0x100, 0x100, 0x100,  /* C0 */
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,  /* C8 */
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,  /* D0 */
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,  /* D8 */
+    0x100, 0x100, 0x180, 0x100, 0x100, 0x100, 0x100, 0x100,  /* E0 */
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x200, 0x100, 0x200,  /* E8 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* F0 */
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,  /* F8 */
+};
+
 /*
  * Allocate a dynamic memory block.
  */
@@ -66,6 +119,125 @@ yaml_strdup(const yaml_char_t *str)
     return (yaml_char_t *)strdup((char *)str);
 }
 
+/*
+ * Hash a string with FNV-1a for the hash tables of anchors, keys and tags.
+ */
+
+YAML_DECLARE(size_t)
+yaml_hash(const yaml_char_t *string, size_t length)
+{
+    size_t hash = 2166136261u;
+    size_t k;
+
+    for (k = 0; k < length; k ++) {
+        hash = (hash ^ string[k]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+ * Allocate a block from an arena.
+ *
+ * Blocks are aligned for pointers.  A block that does not fit in the current
+ * chunk starts a new one, which is taken from the released chunks if it is
+ * not larger than the default size.
+ */
+
+YAML_DECLARE(void *)
+yaml_arena_malloc(struct yaml_arena_s *arena, size_t size)
+{
+    void *pointer;
+
+    if (size > (size_t)-1 - sizeof(void *))
+        return NULL;
+
+    size = (size + sizeof(void *)-1) & ~(sizeof(void *)-1);
+
+    if ((size_t)(arena->end - arena->pointer) < size)
+    {
+        yaml_arena_chunk_t *chunk;
+
+        if (size <= arena->size && arena->spare) {
+            chunk = arena->spare;
+            arena->spare = chunk->next;
+        }
+        else {
+            size_t chunk_size = size > arena->size ? size : arena->size;
+            if (chunk_size > (size_t)-1 - sizeof(yaml_arena_chunk_t))
+                return NULL;
+            chunk = (yaml_arena_chunk_t *)yaml_malloc(
+                    sizeof(yaml_arena_chunk_t) + chunk_size);
+            if (!chunk)
+                return NULL;
+            chunk->size = chunk_size;
+        }
+
+        chunk->next = NULL;
+        if (arena->tail) {
+            arena->tail->next = chunk;
+        }
+        else {
+            arena->head = chunk;
+        }
+        arena->tail = chunk;
+        arena->pointer = (char *)(chunk+1);
+        arena->end = arena->pointer + chunk->size;
+    }
+
+    pointer = arena->pointer;
+    arena->pointer += size;
+
+    return pointer;
+}
+
+/*
+ * Release the chunks of an arena up to a chunk that is still in use.
+ *
+ * If no chunk is in use, the current chunk is kept and reused from its
+ * beginning.
+ */
+
+YAML_DECLARE(void)
+yaml_arena_release(struct yaml_arena_s *arena, yaml_arena_chunk_t *live)
+{
+    while (arena->head != live && arena->head != arena->tail) {
+        yaml_arena_chunk_t *chunk = arena->head;
+        arena->head = chunk->next;
+        if (chunk->size > arena->size) {
+            yaml_free(chunk);
+        }
+        else {
+            chunk->next = arena->spare;
+            arena->spare = chunk;
+        }
+    }
+
+    if (!live && arena->tail) {
+        arena->pointer = (char *)(arena->tail+1);
+    }
+}
+
+/*
+ * Free all chunks of an arena.
+ */
+
+YAML_DECLARE(void)
+yaml_arena_delete(struct yaml_arena_s *arena)
+{
+    while (arena->head) {
+        yaml_arena_chunk_t *chunk = arena->head;
+        arena->head = chunk->next;
+        yaml_free(chunk);
+    }
+    while (arena->spare) {
+        yaml_arena_chunk_t *chunk = arena->spare;
+        arena->spare = chunk->next;
+        yaml_free(chunk);
+    }
+    memset(arena, 0, sizeof(struct yaml_arena_s));
+}
+
 /*
  * Extend a string.
  */
@@ -134,6 +306,39 @@ yaml_stack_extend(void **start, void **top, void **end)
     return 1;
 }
 
+/*
+ * Extend a stack that lives in an arena.
+ *
+ * The stack is moved to a new block of the arena; the old block is kept until
+ * the arena is deleted.  An empty stack gets INITIAL_STACK_SIZE elements of
+ * the given size.
+ */
+
+YAML_DECLARE(int)
+yaml_arena_stack_extend(struct yaml_arena_s *arena,
+        void **start, void **top, void **end, size_t size)
+{
+    size_t length = (char *)*end - (char *)*start;
+    void *new_start;
+
+    if (length >= INT_MAX / 2)
+        return 0;
+
+    length = length ? length*2 : INITIAL_STACK_SIZE*size;
+    new_start = yaml_arena_malloc(arena, length);
+
+    if (!new_start) return 0;
+
+    if (*start) {
+        memcpy(new_start, *start, (char *)*top - (char *)*start);
+    }
+    *top = (char *)new_start + ((char *)*top - (char *)*start);
+    *end = (char *)new_start + length;
+    *start = new_start;
+
+    return 1;
+}
+
 /*
  * Extend or move a queue.
  */
@@ -141,9 +346,13 @@ yaml_stack_extend(void **start, void **top, void **end)
 YAML_DECLARE(int)
 yaml_queue_extend(void **start, void **head, void **tail, void **end)
 {
-    /* Check if we need to resize the queue. */
+    /*
+     * Check if we need to resize the queue.  Unless a half of the queue is
+     * free, moving it would take as long as its growth.
+     */
 
-    if (*start == *head && *tail == *end) {
+    if (*tail == *end && ((char *)*head - (char *)*start)
+                < ((char *)*end - (char *)*start)/2) {
         void *new_start = yaml_realloc(*start,
                 ((char *)*end - (char *)*start)*2);
 
@@ -185,6 +394,9 @@ yaml_parser_initialize(yaml_parser_t *parser)
         goto error;
     if (!QUEUE_INIT(parser, parser->tokens, INITIAL_QUEUE_SIZE, yaml_token_t*))
         goto error;
+    if (!QUEUE_INIT(parser, parser->pending_tokens, INITIAL_QUEUE_SIZE,
+                yaml_pending_token_t*))
+        goto error;
     if (!STACK_INIT(parser, parser->indents, int*))
         goto error;
     if (!STACK_INIT(parser, parser->simple_keys, yaml_simple_key_t*))
@@ -203,6 +415,7 @@ error:
     BUFFER_DEL(parser, parser->raw_buffer);
     BUFFER_DEL(parser, parser->buffer);
     QUEUE_DEL(parser, parser->tokens);
+    QUEUE_DEL(parser, parser->pending_tokens);
     STACK_DEL(parser, parser->indents);
     STACK_DEL(parser, parser->simple_keys);
     STACK_DEL(parser, parser->states);
@@ -221,14 +434,35 @@ yaml_parser_delete(yaml_parser_t *parser)
 {
     assert(parser); /* Non-NULL parser object expected. */
 
+#if HAVE_PTHREAD_H
+    if (parser->read_ahead) {
+        yaml_parser_stop_read_ahead(parser);
+    }
+#endif
     BUFFER_DEL(parser, parser->raw_buffer);
+    if (parser->buffer_storage.start) {
+        parser->buffer.start = parser->buffer_storage.start;
+    }
     BUFFER_DEL(parser, parser->buffer);
+    if (parser->read_handler == yaml_feed_read_handler) {
+        BUFFER_DEL(parser, parser->input.feed);
+    }
+#if HAVE_SYS_MMAN_H
+    if (parser->mapping.start) {
+        munmap(parser->mapping.start, parser->mapping.size);
+    }
+#endif
     while (!QUEUE_EMPTY(parser, parser->tokens)) {
         yaml_token_delete(&DEQUEUE(parser, parser->tokens));
     }
     QUEUE_DEL(parser, parser->tokens);
+    QUEUE_DEL(parser, parser->pending_tokens);
     STACK_DEL(parser, parser->indents);
     STACK_DEL(parser, parser->simple_keys);
+    STRING_DEL(parser, parser->scratch_string);
+    STRING_DEL(parser, parser->scratch_leading_break);
+    STRING_DEL(parser, parser->scratch_trailing_breaks);
+    STRING_DEL(parser, parser->scratch_whitespaces);
     STACK_DEL(parser, parser->states);
     STACK_DEL(parser, parser->marks);
     while (!STACK_EMPTY(parser, parser->tag_directives)) {
@@ -237,6 +471,13 @@ yaml_parser_delete(yaml_parser_t *parser)
         yaml_free(tag_directive.prefix);
     }
     STACK_DEL(parser, parser->tag_directives);
+    if (parser->arena) {
+        yaml_arena_delete(parser->arena);
+        yaml_free(parser->arena);
+    }
+    STACK_DEL(parser, parser->items);
+    STACK_DEL(parser, parser->pairs);
+    yaml_free(parser->tag_index.start);
 
     memset(parser, 0, sizeof(yaml_parser_t));
 }
@@ -245,7 +486,7 @@ yaml_parser_delete(yaml_parser_t *parser)
  * String read handler.
  */
 
-static int
+YAML_DECLARE(int)
 yaml_string_read_handler(void *data, unsigned char *buffer, size_t size,
         size_t *size_read)
 {
@@ -268,83 +509,613 @@ yaml_string_read_handler(void *data, unsigned char *buffer, size_t size,
 }
 
 /*
- * File read handler.
+ * File read handler.
+ */
+
+static int
+yaml_file_read_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read)
+{
+    yaml_parser_t *parser = (yaml_parser_t *)data;
+
+    *size_read = fread(buffer, 1, size, parser->input.file);
+    return !ferror(parser->input.file);
+}
+
+/*
+ * Pushed input read handler.
+ *
+ * The reader does not call it while the fed data is exhausted and the end of
+ * the input is not fed yet.
+ */
+
+YAML_DECLARE(int)
+yaml_feed_read_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read)
+{
+    yaml_parser_t *parser = (yaml_parser_t *)data;
+
+    if (size > (size_t)(parser->input.feed.last
+                - parser->input.feed.pointer)) {
+        size = parser->input.feed.last - parser->input.feed.pointer;
+    }
+
+    memcpy(buffer, parser->input.feed.pointer, size);
+    parser->input.feed.pointer += size;
+    *size_read = size;
+    return 1;
+}
+
+#if HAVE_PTHREAD_H
+
+/*
+ * The state of a read-ahead thread.
+ *
+ * The chunks form a ring.  The helper thread fills the chunk at `tail`, and
+ * the reader empties the chunk at `head`.  The counters only grow; the mutex
+ * guards them and the flags, but not the chunks, since the chunk between the
+ * counters belongs to one thread at a time.
+ */
+
+struct yaml_read_ahead_s {
+    yaml_read_handler_t *handler;   /* The read handler of the input. */
+    void *data;                     /* The data of the read handler. */
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;            /* Signalled when a counter moves. */
+    unsigned char *chunks;
+    size_t *lengths;                /* The number of octets in the chunks. */
+    size_t count;                   /* The number of chunks. */
+    size_t size;                    /* The size of a chunk. */
+    size_t head;                    /* The number of emptied chunks. */
+    size_t tail;                    /* The number of filled chunks. */
+    size_t pointer;                 /* The position in the head chunk. */
+    int eof;                        /* Is the end of the input reached? */
+    int failed;                     /* Has the read handler failed? */
+    int stopped;                    /* Is the parser deleted? */
+};
+
+/*
+ * The read-ahead thread.
+ */
+
+static void *
+yaml_read_ahead_thread(void *data)
+{
+    struct yaml_read_ahead_s *read_ahead = (struct yaml_read_ahead_s *)data;
+
+    while (1)
+    {
+        unsigned char *chunk;
+        size_t length = 0;
+        int failed;
+
+        /* Wait for an empty chunk. */
+
+        pthread_mutex_lock(&read_ahead->mutex);
+        while (read_ahead->tail - read_ahead->head == read_ahead->count
+                && !read_ahead->stopped) {
+            pthread_cond_wait(&read_ahead->cond, &read_ahead->mutex);
+        }
+        if (read_ahead->stopped) {
+            pthread_mutex_unlock(&read_ahead->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&read_ahead->mutex);
+
+        /* Fill it. */
+
+        chunk = read_ahead->chunks
+            + (read_ahead->tail % read_ahead->count) * read_ahead->size;
+        failed = !read_ahead->handler(read_ahead->data,
+                chunk, read_ahead->size, &length);
+
+        /* Pass it to the reader. */
+
+        pthread_mutex_lock(&read_ahead->mutex);
+        if (failed) {
+            read_ahead->failed = 1;
+        }
+        else if (!length) {
+            read_ahead->eof = 1;
+        }
+        else {
+            read_ahead->lengths[read_ahead->tail % read_ahead->count] = length;
+            read_ahead->tail ++;
+        }
+        pthread_cond_signal(&read_ahead->cond);
+        pthread_mutex_unlock(&read_ahead->mutex);
+
+        if (failed || !length)
+            break;
+    }
+
+    return NULL;
+}
+
+/*
+ * Read-ahead read handler.
+ *
+ * The handler takes the chunks filled by the read-ahead thread and waits only
+ * if none is ready.
+ */
+
+static int
+yaml_read_ahead_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read)
+{
+    struct yaml_read_ahead_s *read_ahead = (struct yaml_read_ahead_s *)data;
+    size_t index;
+    size_t length;
+
+    pthread_mutex_lock(&read_ahead->mutex);
+    while (read_ahead->head == read_ahead->tail
+            && !read_ahead->eof && !read_ahead->failed) {
+        pthread_cond_wait(&read_ahead->cond, &read_ahead->mutex);
+    }
+    if (read_ahead->head == read_ahead->tail) {
+        pthread_mutex_unlock(&read_ahead->mutex);
+        *size_read = 0;
+        return !read_ahead->failed;
+    }
+    index = read_ahead->head % read_ahead->count;
+    length = read_ahead->lengths[index];
+    pthread_mutex_unlock(&read_ahead->mutex);
+
+    if (size > length - read_ahead->pointer) {
+        size = length - read_ahead->pointer;
+    }
+
+    memcpy(buffer, read_ahead->chunks + index * read_ahead->size
+            + read_ahead->pointer, size);
+    read_ahead->pointer += size;
+    *size_read = size;
+
+    /* Return the emptied chunk to the thread. */
+
+    if (read_ahead->pointer == length) {
+        pthread_mutex_lock(&read_ahead->mutex);
+        read_ahead->head ++;
+        read_ahead->pointer = 0;
+        pthread_cond_signal(&read_ahead->cond);
+        pthread_mutex_unlock(&read_ahead->mutex);
+    }
+
+    return 1;
+}
+
+/*
+ * Stop the read-ahead thread and free its state.
+ */
+
+static void
+yaml_parser_stop_read_ahead(yaml_parser_t *parser)
+{
+    struct yaml_read_ahead_s *read_ahead = parser->read_ahead;
+
+    pthread_mutex_lock(&read_ahead->mutex);
+    read_ahead->stopped = 1;
+    pthread_cond_signal(&read_ahead->cond);
+    pthread_mutex_unlock(&read_ahead->mutex);
+
+    pthread_join(read_ahead->thread, NULL);
+    pthread_cond_destroy(&read_ahead->cond);
+    pthread_mutex_destroy(&read_ahead->mutex);
+
+    yaml_free(read_ahead->chunks);
+    yaml_free(read_ahead->lengths);
+    yaml_free(read_ahead);
+    parser->read_ahead = NULL;
+}
+
+#endif
+
+/*
+ * Set a string input.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_input_string(yaml_parser_t *parser,
+        const unsigned char *input, size_t size)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+    assert(input);  /* Non-NULL input string expected. */
+
+    parser->read_handler = yaml_string_read_handler;
+    parser->read_handler_data = parser;
+
+    parser->input.string.start = input;
+    parser->input.string.current = input;
+    parser->input.string.end = input+size;
+}
+
+/*
+ * Set a file input.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_input_file(yaml_parser_t *parser, FILE *file)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+    assert(file);   /* Non-NULL file object expected. */
+
+    parser->read_handler = yaml_file_read_handler;
+    parser->read_handler_data = parser;
+
+    parser->input.file = file;
+}
+
+/*
+ * Set a memory-mapped file input.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_set_input_mmap(yaml_parser_t *parser, int fd)
+{
+#if HAVE_SYS_MMAN_H
+    struct stat st;
+    void *start;
+    size_t size;
+
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode)
+            || (off_t)(size_t)st.st_size != st.st_size) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot map the input file";
+        parser->problem_value = -1;
+        return 0;
+    }
+
+    size = (size_t)st.st_size;
+
+    /* An empty file cannot be mapped. */
+
+    if (!size) {
+        yaml_parser_set_input_string(parser, (const unsigned char *)"", 0);
+        return 1;
+    }
+
+    start = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (start == MAP_FAILED) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot map the input file";
+        parser->problem_value = -1;
+        return 0;
+    }
+
+#if defined(MADV_SEQUENTIAL)
+    madvise(start, size, MADV_SEQUENTIAL);
+#endif
+
+    parser->mapping.start = start;
+    parser->mapping.size = size;
+    parser->mapping.resident = start;
+
+    yaml_parser_set_input_string(parser, start, size);
+
+    return 1;
+#else
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+
+    (void)fd;
+
+    parser->error = YAML_READER_ERROR;
+    parser->problem = "memory-mapped input is not supported";
+    parser->problem_value = -1;
+    return 0;
+#endif
+}
+
+/*
+ * Feed a chunk of a pushed input.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_feed(yaml_parser_t *parser,
+        const unsigned char *data, size_t size, int is_final)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(data || !size);  /* Non-NULL data expected. */
+
+    if (!parser->read_handler) {
+        if (!BUFFER_INIT(parser, parser->input.feed, INPUT_RAW_BUFFER_SIZE))
+            return 0;
+        parser->read_handler = yaml_feed_read_handler;
+        parser->read_handler_data = parser;
+    }
+
+    assert(parser->read_handler == yaml_feed_read_handler);
+                                    /* You can only feed a pushed input. */
+    assert(!parser->input.feed.final);  /* No input after the end. */
+
+    /* Move the unread data to the beginning of the buffer. */
+
+    if (parser->input.feed.start < parser->input.feed.pointer) {
+        size_t unread = parser->input.feed.last - parser->input.feed.pointer;
+        memmove(parser->input.feed.start, parser->input.feed.pointer, unread);
+        parser->input.feed.pointer = parser->input.feed.start;
+        parser->input.feed.last = parser->input.feed.start + unread;
+    }
+
+    /* Grow the buffer if the chunk does not fit. */
+
+    if ((size_t)(parser->input.feed.end - parser->input.feed.last) < size) {
+        size_t unread = parser->input.feed.last - parser->input.feed.start;
+        size_t capacity = parser->input.feed.end - parser->input.feed.start;
+        unsigned char *start;
+
+        while (capacity - unread < size) {
+            if (capacity > MAX_FILE_SIZE/2) {
+                parser->error = YAML_MEMORY_ERROR;
+                return 0;
+            }
+            capacity *= 2;
+        }
+
+        start = yaml_realloc(parser->input.feed.start, capacity);
+        if (!start) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+
+        parser->input.feed.start = start;
+        parser->input.feed.pointer = start;
+        parser->input.feed.last = start + unread;
+        parser->input.feed.end = start + capacity;
+    }
+
+    if (size) {
+        memcpy(parser->input.feed.last, data, size);
+        parser->input.feed.last += size;
+    }
+    parser->input.feed.final = is_final;
+
+    return 1;
+}
+
+/*
+ * Set a generic input.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_input(yaml_parser_t *parser,
+        yaml_read_handler_t *handler, void *data)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->read_handler);  /* You can set the source only once. */
+    assert(handler);    /* Non-NULL read handler expected. */
+
+    parser->read_handler = handler;
+    parser->read_handler_data = data;
+}
+
+/*
+ * Read the input ahead in a background thread.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_set_read_ahead(yaml_parser_t *parser, size_t count, size_t size)
+{
+#if HAVE_PTHREAD_H
+    struct yaml_read_ahead_s *read_ahead;
+    int mutex = 0, cond = 0;
+#endif
+
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(parser->read_handler);   /* The input must be set first. */
+    assert(parser->read_handler != yaml_string_read_handler
+            && parser->read_handler != yaml_feed_read_handler);
+                            /* Only a file or generic input is read ahead. */
+    assert(!parser->read_ahead);    /* You can set the read-ahead only once. */
+
+#if HAVE_PTHREAD_H
+    if (!count) count = READ_AHEAD_CHUNK_COUNT;
+    if (!size) size = READ_AHEAD_CHUNK_SIZE;
+
+    if (count > MAX_FILE_SIZE/size
+            || count > MAX_FILE_SIZE/sizeof(*read_ahead->lengths)) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    read_ahead = YAML_MALLOC_STATIC(struct yaml_read_ahead_s);
+    if (!read_ahead) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(read_ahead, 0, sizeof(*read_ahead));
+
+    read_ahead->chunks = YAML_MALLOC(count*size);
+    read_ahead->lengths = (size_t *)yaml_malloc(
+            count*sizeof(*read_ahead->lengths));
+    if (!read_ahead->chunks || !read_ahead->lengths) {
+        parser->error = YAML_MEMORY_ERROR;
+        goto error;
+    }
+
+    read_ahead->handler = parser->read_handler;
+    read_ahead->data = parser->read_handler_data;
+    read_ahead->count = count;
+    read_ahead->size = size;
+
+    mutex = !pthread_mutex_init(&read_ahead->mutex, NULL);
+    cond = mutex && !pthread_cond_init(&read_ahead->cond, NULL);
+    if (!cond || pthread_create(&read_ahead->thread, NULL,
+                yaml_read_ahead_thread, read_ahead)) {
+        parser->error = YAML_READER_ERROR;
+        parser->problem = "cannot start the read-ahead thread";
+        parser->problem_value = -1;
+        goto error;
+    }
+
+    parser->read_ahead = read_ahead;
+    parser->read_handler = yaml_read_ahead_handler;
+    parser->read_handler_data = read_ahead;
+
+    return 1;
+
+error:
+
+    if (cond) pthread_cond_destroy(&read_ahead->cond);
+    if (mutex) pthread_mutex_destroy(&read_ahead->mutex);
+    yaml_free(read_ahead->chunks);
+    yaml_free(read_ahead->lengths);
+    yaml_free(read_ahead);
+
+    return 0;
+#else
+    (void)count;
+    (void)size;
+
+    return 1;
+#endif
+}
+
+/*
+ * Set the source encoding.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding)
+{
+    assert(parser); /* Non-NULL parser object expected. */
+    assert(!parser->encoding); /* Encoding is already set or detected. */
+
+    parser->encoding = encoding;
+}
+
+/*
+ * Let scalars point into the input.
  */
 
-static int
-yaml_file_read_handler(void *data, unsigned char *buffer, size_t size,
-        size_t *size_read)
+YAML_DECLARE(void)
+yaml_parser_set_zero_copy(yaml_parser_t *parser, int enabled)
 {
-    yaml_parser_t *parser = (yaml_parser_t *)data;
+    assert(parser); /* Non-NULL parser object expected. */
 
-    *size_read = fread(buffer, 1, size, parser->input.file);
-    return !ferror(parser->input.file);
+    parser->zero_copy = enabled;
 }
 
 /*
- * Set a string input.
+ * Set whether the JSON tokenizer is used.
  */
 
 YAML_DECLARE(void)
-yaml_parser_set_input_string(yaml_parser_t *parser,
-        const unsigned char *input, size_t size)
+yaml_parser_set_json_mode(yaml_parser_t *parser, int enabled)
 {
     assert(parser); /* Non-NULL parser object expected. */
-    assert(!parser->read_handler);  /* You can set the source only once. */
-    assert(input);  /* Non-NULL input string expected. */
 
-    parser->read_handler = yaml_string_read_handler;
-    parser->read_handler_data = parser;
-
-    parser->input.string.start = input;
-    parser->input.string.current = input;
-    parser->input.string.end = input+size;
+    parser->json_mode = enabled ? 1 : -1;
 }
 
 /*
- * Set a file input.
+ * Allocate the strings of tokens and events from an arena.
  */
 
-YAML_DECLARE(void)
-yaml_parser_set_input_file(yaml_parser_t *parser, FILE *file)
+YAML_DECLARE(int)
+yaml_parser_set_arena(yaml_parser_t *parser, size_t size)
 {
     assert(parser); /* Non-NULL parser object expected. */
-    assert(!parser->read_handler);  /* You can set the source only once. */
-    assert(file);   /* Non-NULL file object expected. */
+    assert(!parser->arena); /* The arena can be set only once. */
+    assert(!parser->stream_start_produced); /* The parsing is not started. */
 
-    parser->read_handler = yaml_file_read_handler;
-    parser->read_handler_data = parser;
+    parser->arena = YAML_MALLOC_STATIC(struct yaml_arena_s);
+    if (!parser->arena) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(parser->arena, 0, sizeof(struct yaml_arena_s));
+    parser->arena->size = size ? size : ARENA_CHUNK_SIZE;
 
-    parser->input.file = file;
+    return 1;
 }
 
 /*
- * Set a generic input.
+ * Load the documents into arenas.
  */
 
 YAML_DECLARE(void)
-yaml_parser_set_input(yaml_parser_t *parser,
-        yaml_read_handler_t *handler, void *data)
+yaml_parser_set_document_arena(yaml_parser_t *parser, size_t size)
 {
     assert(parser); /* Non-NULL parser object expected. */
-    assert(!parser->read_handler);  /* You can set the source only once. */
-    assert(handler);    /* Non-NULL read handler expected. */
 
-    parser->read_handler = handler;
-    parser->read_handler_data = data;
+    parser->document_arena = size ? size : ARENA_CHUNK_SIZE;
 }
 
 /*
- * Set the source encoding.
+ * Release the strings of the tokens and events produced by the parser.
+ *
+ * The scanner allocates the strings of the tokens in the order of the tokens
+ * queue, so the chunks before the first one with a string of a queued token
+ * hold only strings of the produced tokens and events.
  */
 
 YAML_DECLARE(void)
-yaml_parser_set_encoding(yaml_parser_t *parser, yaml_encoding_t encoding)
+yaml_parser_release_arena(yaml_parser_t *parser)
 {
+    yaml_token_t *token;
+    yaml_arena_chunk_t *live = NULL;
+
     assert(parser); /* Non-NULL parser object expected. */
-    assert(!parser->encoding); /* Encoding is already set or detected. */
 
-    parser->encoding = encoding;
+    if (!parser->arena)
+        return;
+
+    for (token = parser->tokens.head;
+            token != parser->tokens.tail && !live; token ++)
+    {
+        yaml_char_t *strings[2] = { NULL, NULL };
+        yaml_arena_chunk_t *chunk;
+
+        switch (token->type)
+        {
+            case YAML_ALIAS_TOKEN:
+                strings[0] = token->data.alias.value;
+                break;
+
+            case YAML_ANCHOR_TOKEN:
+                strings[0] = token->data.anchor.value;
+                break;
+
+            case YAML_TAG_TOKEN:
+                strings[0] = token->data.tag.handle;
+                strings[1] = token->data.tag.suffix;
+                break;
+
+            case YAML_TAG_DIRECTIVE_TOKEN:
+                strings[0] = token->data.tag_directive.handle;
+                strings[1] = token->data.tag_directive.prefix;
+                break;
+
+            case YAML_SCALAR_TOKEN:
+                if (!token->data.scalar.borrowed) {
+                    strings[0] = token->data.scalar.value;
+                }
+                break;
+
+            default:
+                continue;
+        }
+
+        for (chunk = parser->arena->head; chunk && !live;
+                chunk = chunk->next) {
+            char *start = (char *)(chunk+1);
+            int k;
+            for (k = 0; k < 2; k ++) {
+                if ((char *)strings[k] >= start
+                        && (char *)strings[k] < start + chunk->size) {
+                    live = chunk;
+                }
+            }
+        }
+    }
+
+    yaml_arena_release(parser->arena, live);
 }
 
 /*
@@ -585,6 +1356,13 @@ yaml_token_delete(yaml_token_t *token)
 {
     assert(token);  /* Non-NULL token object expected. */
 
+    /* The strings of the token may be owned by the parser arena. */
+
+    if (token->arena) {
+        memset(token, 0, sizeof(yaml_token_t));
+        return;
+    }
+
     switch (token->type)
     {
         case YAML_TAG_DIRECTIVE_TOKEN:
@@ -606,7 +1384,9 @@ yaml_token_delete(yaml_token_t *token)
             break;
 
         case YAML_SCALAR_TOKEN:
-            yaml_free(token->data.scalar.value);
+            if (!token->data.scalar.borrowed) {
+                yaml_free(token->data.scalar.value);
+            }
             break;
 
         default:
@@ -988,6 +1768,13 @@ yaml_event_delete(yaml_event_t *event)
 
     assert(event);  /* Non-NULL event object expected. */
 
+    /* The strings of the event may be owned by the parser arena. */
+
+    if (event->arena) {
+        memset(event, 0, sizeof(yaml_event_t));
+        return;
+    }
+
     switch (event->type)
     {
         case YAML_DOCUMENT_START_EVENT:
@@ -1008,7 +1795,9 @@ yaml_event_delete(yaml_event_t *event)
         case YAML_SCALAR_EVENT:
             yaml_free(event->data.scalar.anchor);
             yaml_free(event->data.scalar.tag);
-            yaml_free(event->data.scalar.value);
+            if (!event->data.scalar.borrowed) {
+                yaml_free(event->data.scalar.value);
+            }
             break;
 
         case YAML_SEQUENCE_START_EVENT:
@@ -1126,6 +1915,14 @@ yaml_document_delete(yaml_document_t *document)
 
     assert(document);   /* Non-NULL document object is expected. */
 
+    if (document->arena) {
+        STACK_DEL(&context, document->nodes);
+        yaml_arena_delete(document->arena);
+        yaml_free(document->arena);
+        memset(document, 0, sizeof(yaml_document_t));
+        return;
+    }
+
     while (!STACK_EMPTY(&context, document->nodes)) {
         yaml_node_t node = POP(&context, document->nodes);
         yaml_free(node.tag);
@@ -1138,6 +1935,7 @@ yaml_document_delete(yaml_document_t *document)
                 break;
             case YAML_MAPPING_NODE:
                 STACK_DEL(&context, node.data.mapping.pairs);
+                yaml_free(node.data.mapping.index.start);
                 break;
             default:
                 assert(0);  /* Should not happen. */
@@ -1187,6 +1985,24 @@ yaml_document_get_root_node(yaml_document_t *document)
     return NULL;
 }
 
+/*
+ * Copy a string to a block of a document.
+ */
+
+static yaml_char_t *
+yaml_document_copy_string(yaml_document_t *document,
+        const yaml_char_t *string, size_t length)
+{
+    yaml_char_t *copy = (yaml_char_t *)DOCUMENT_MALLOC(document, length+1);
+
+    if (!copy) return NULL;
+
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+
+    return copy;
+}
+
 /*
  * Add a scalar node to a document.
  */
@@ -1212,7 +2028,7 @@ yaml_document_add_scalar(yaml_document_t *document,
     }
 
     if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
-    tag_copy = yaml_strdup(tag);
+    tag_copy = yaml_document_copy_string(document, tag, strlen((char *)tag));
     if (!tag_copy) goto error;
 
     if (length < 0) {
@@ -1220,10 +2036,8 @@ yaml_document_add_scalar(yaml_document_t *document,
     }
 
     if (!yaml_check_utf8(value, length)) goto error;
-    value_copy = YAML_MALLOC(length+1);
+    value_copy = yaml_document_copy_string(document, value, length);
     if (!value_copy) goto error;
-    memcpy(value_copy, value, length);
-    value_copy[length] = '\0';
 
     SCALAR_NODE_INIT(node, tag_copy, value_copy, length, style, mark, mark);
     if (!PUSH(&context, document->nodes, node)) goto error;
@@ -1231,8 +2045,8 @@ yaml_document_add_scalar(yaml_document_t *document,
     return document->nodes.top - document->nodes.start;
 
 error:
-    yaml_free(tag_copy);
-    yaml_free(value_copy);
+    DOCUMENT_FREE(document, tag_copy);
+    DOCUMENT_FREE(document, value_copy);
 
     return 0;
 }
@@ -1264,10 +2078,13 @@ yaml_document_add_sequence(yaml_document_t *document,
     }
 
     if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
-    tag_copy = yaml_strdup(tag);
+    tag_copy = yaml_document_copy_string(document, tag, strlen((char *)tag));
     if (!tag_copy) goto error;
 
-    if (!STACK_INIT(&context, items, yaml_node_item_t*)) goto error;
+    /* The items of an arena document are allocated on the first append. */
+
+    if (!document->arena && !STACK_INIT(&context, items, yaml_node_item_t*))
+        goto error;
 
     SEQUENCE_NODE_INIT(node, tag_copy, items.start, items.end,
             style, mark, mark);
@@ -1277,7 +2094,7 @@ yaml_document_add_sequence(yaml_document_t *document,
 
 error:
     STACK_DEL(&context, items);
-    yaml_free(tag_copy);
+    DOCUMENT_FREE(document, tag_copy);
 
     return 0;
 }
@@ -1309,10 +2126,13 @@ yaml_document_add_mapping(yaml_document_t *document,
     }
 
     if (!yaml_check_utf8(tag, strlen((char *)tag))) goto error;
-    tag_copy = yaml_strdup(tag);
+    tag_copy = yaml_document_copy_string(document, tag, strlen((char *)tag));
     if (!tag_copy) goto error;
 
-    if (!STACK_INIT(&context, pairs, yaml_node_pair_t*)) goto error;
+    /* The pairs of an arena document are allocated on the first append. */
+
+    if (!document->arena && !STACK_INIT(&context, pairs, yaml_node_pair_t*))
+        goto error;
 
     MAPPING_NODE_INIT(node, tag_copy, pairs.start, pairs.end,
             style, mark, mark);
@@ -1322,7 +2142,7 @@ yaml_document_add_mapping(yaml_document_t *document,
 
 error:
     STACK_DEL(&context, pairs);
-    yaml_free(tag_copy);
+    DOCUMENT_FREE(document, tag_copy);
 
     return 0;
 }
@@ -1348,7 +2168,7 @@ yaml_document_append_sequence_item(yaml_document_t *document,
     assert(item > 0 && document->nodes.start + item <= document->nodes.top);
                             /* Valid item id is required. */
 
-    if (!PUSH(&context,
+    if (!DOCUMENT_PUSH(&context, document,
                 document->nodes.start[sequence-1].data.sequence.items, item))
         return 0;
 
@@ -1368,6 +2188,7 @@ yaml_document_append_mapping_pair(yaml_document_t *document,
     } context;
 
     yaml_node_pair_t pair;
+    yaml_node_t *node;
 
     assert(document);       /* Non-NULL document is required. */
     assert(mapping > 0
@@ -1383,10 +2204,326 @@ yaml_document_append_mapping_pair(yaml_document_t *document,
     pair.key = key;
     pair.value = value;
 
-    if (!PUSH(&context,
+    if (!DOCUMENT_PUSH(&context, document,
                 document->nodes.start[mapping-1].data.mapping.pairs, pair))
         return 0;
 
+    /* Keep the hash table of the keys at most half full. */
+
+    node = document->nodes.start + mapping-1;
+    if (node->data.mapping.index.start) {
+        int count = node->data.mapping.pairs.top
+            - node->data.mapping.pairs.start;
+        if ((size_t)count*2 > (size_t)(node->data.mapping.index.end
+                    - node->data.mapping.index.start)) {
+            DOCUMENT_FREE(document, node->data.mapping.index.start);
+            node->data.mapping.index.start = NULL;
+            node->data.mapping.index.end = NULL;
+        }
+        else {
+            yaml_document_index_pair(document, node, count-1);
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Find the slot of a key in the hash table of a mapping, or the empty slot
+ * where it belongs.
+ *
+ * The table is searched linearly from the FNV-1a hash of the key.
+ */
+
+static int *
+yaml_document_find_key(yaml_document_t *document, yaml_node_t *mapping,
+        const yaml_char_t *key, size_t length)
+{
+    int *index = mapping->data.mapping.index.start;
+    size_t mask = (mapping->data.mapping.index.end - index) - 1;
+    size_t hash = yaml_hash(key, length);
+
+    for (hash &= mask; index[hash]; hash = (hash+1) & mask) {
+        yaml_node_t *node = document->nodes.start
+            + mapping->data.mapping.pairs.start[index[hash]-1].key - 1;
+        if (node->data.scalar.length == length
+                && memcmp(node->data.scalar.value, key, length) == 0)
+            break;
+    }
+
+    return index + hash;
+}
+
+/*
+ * Add the key of a pair to the hash table of a mapping unless it is not a
+ * scalar or it is there already.
+ */
+
+static void
+yaml_document_index_pair(yaml_document_t *document, yaml_node_t *mapping,
+        int position)
+{
+    yaml_node_t *key = document->nodes.start
+        + mapping->data.mapping.pairs.start[position].key - 1;
+    int *slot;
+
+    if (key->type != YAML_SCALAR_NODE) return;
+
+    slot = yaml_document_find_key(document, mapping,
+            key->data.scalar.value, key->data.scalar.length);
+    if (!*slot) {
+        *slot = position+1;
+    }
+}
+
+/*
+ * Build the hash table of the keys of a mapping.
+ */
+
+static int
+yaml_document_index_mapping(yaml_document_t *document, yaml_node_t *mapping)
+{
+    int count = mapping->data.mapping.pairs.top
+        - mapping->data.mapping.pairs.start;
+    size_t size = INITIAL_TABLE_SIZE;
+    int *index;
+    int position;
+
+    while (size < (size_t)count*2) {
+        size *= 2;
+    }
+    if (size > (size_t)-1 / sizeof(int))
+        return 0;
+
+    index = (int *)DOCUMENT_MALLOC(document, size*sizeof(int));
+    if (!index) return 0;
+    memset(index, 0, size*sizeof(int));
+
+    mapping->data.mapping.index.start = index;
+    mapping->data.mapping.index.end = index + size;
+
+    for (position = 0; position < count; position ++) {
+        yaml_document_index_pair(document, mapping, position);
+    }
+
+    return 1;
+}
+
+/*
+ * Find the value of a scalar key in a mapping node.
+ */
+
+YAML_DECLARE(yaml_node_t *)
+yaml_document_mapping_get(yaml_document_t *document,
+        int mapping, const yaml_char_t *key, int length)
+{
+    yaml_node_t *node;
+    yaml_node_pair_t *pair;
+
+    assert(document);       /* Non-NULL document is required. */
+    assert(mapping > 0
+            && document->nodes.start + mapping <= document->nodes.top);
+                            /* Valid mapping id is required. */
+    assert(document->nodes.start[mapping-1].type == YAML_MAPPING_NODE);
+                            /* A mapping node is required. */
+    assert(key);            /* Non-NULL key is required. */
+
+    if (length < 0) {
+        length = strlen((char *)key);
+    }
+
+    node = document->nodes.start + mapping-1;
+
+    if (!node->data.mapping.index.start
+            && node->data.mapping.pairs.top - node->data.mapping.pairs.start
+                >= MAPPING_INDEX_THRESHOLD) {
+        yaml_document_index_mapping(document, node);
+    }
+
+    if (node->data.mapping.index.start) {
+        int *slot = yaml_document_find_key(document, node, key, length);
+        if (!*slot) return NULL;
+        return document->nodes.start
+            + node->data.mapping.pairs.start[*slot-1].value - 1;
+    }
+
+    /* A small mapping, or one that could not be indexed, is searched. */
+
+    for (pair = node->data.mapping.pairs.start;
+            pair != node->data.mapping.pairs.top; pair ++) {
+        yaml_node_t *key_node = document->nodes.start + pair->key - 1;
+        if (key_node->type == YAML_SCALAR_NODE
+                && key_node->data.scalar.length == (size_t)length
+                && memcmp(key_node->data.scalar.value, key, length) == 0)
+            return document->nodes.start + pair->value - 1;
+    }
+
+    return NULL;
+}
+
+/*
+ * Build the hash tables of the keys of all mapping nodes.
+ */
+
+YAML_DECLARE(int)
+yaml_document_build_indexes(yaml_document_t *document)
+{
+    yaml_node_t *node;
+
+    assert(document);       /* Non-NULL document is required. */
+
+    for (node = document->nodes.start; node != document->nodes.top; node ++) {
+        if (node->type == YAML_MAPPING_NODE
+                && !node->data.mapping.index.start
+                && node->data.mapping.pairs.top - node->data.mapping.pairs.start
+                    >= MAPPING_INDEX_THRESHOLD
+                && !yaml_document_index_mapping(document, node))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Destroy a compact document object.
+ */
+
+YAML_DECLARE(void)
+yaml_compact_document_delete(yaml_compact_document_t *document)
+{
+    yaml_tag_directive_t *tag_directive;
+
+    assert(document);   /* Non-NULL document object is expected. */
+
+    yaml_free(document->types);
+    yaml_free(document->styles);
+    yaml_free(document->tags);
+    yaml_free(document->offsets);
+    yaml_free(document->lengths);
+    yaml_free(document->start_marks);
+    yaml_free(document->end_marks);
+    yaml_free(document->children.start);
+    yaml_free(document->strings.start);
+    yaml_free(document->tag_list.start);
+
+    yaml_free(document->version_directive);
+    for (tag_directive = document->tag_directives.start;
+            tag_directive != document->tag_directives.end;
+            tag_directive++) {
+        yaml_free(tag_directive->handle);
+        yaml_free(tag_directive->prefix);
+    }
+    yaml_free(document->tag_directives.start);
+
+    memset(document, 0, sizeof(yaml_compact_document_t));
+}
+
+/*
+ * Get the type of a compact node.
+ */
+
+YAML_DECLARE(yaml_node_type_t)
+yaml_compact_node_type(yaml_compact_document_t *document, int node)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+
+    return (yaml_node_type_t)document->types[node-1];
+}
+
+/*
+ * Get the tag of a compact node.
+ */
+
+YAML_DECLARE(const yaml_char_t *)
+yaml_compact_node_tag(yaml_compact_document_t *document, int node)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+
+    return document->strings.start
+        + document->tag_list.start[document->tags[node-1]];
+}
+
+/*
+ * Get the style of a compact node.
+ */
+
+YAML_DECLARE(int)
+yaml_compact_node_style(yaml_compact_document_t *document, int node)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+
+    return document->styles[node-1];
+}
+
+/*
+ * Get the value of a compact scalar node.
+ */
+
+YAML_DECLARE(const yaml_char_t *)
+yaml_compact_node_value(yaml_compact_document_t *document, int node,
+        size_t *length)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+
+    if (document->types[node-1] != YAML_SCALAR_NODE) {
+        if (length) *length = 0;
+        return NULL;
+    }
+
+    if (length) *length = document->lengths[node-1];
+    return document->strings.start + document->offsets[node-1];
+}
+
+/*
+ * Get the children of a compact collection node.
+ */
+
+YAML_DECLARE(const int *)
+yaml_compact_node_children(yaml_compact_document_t *document, int node,
+        int *count)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+    assert(count);      /* Non-NULL count is expected. */
+
+    if (document->types[node-1] == YAML_SCALAR_NODE
+            || !document->lengths[node-1]) {
+        *count = 0;
+        return NULL;
+    }
+
+    *count = (int)document->lengths[node-1];
+    return document->children.start + document->offsets[node-1];
+}
+
+/*
+ * Get the marks of a compact node.
+ */
+
+YAML_DECLARE(int)
+yaml_compact_node_marks(yaml_compact_document_t *document, int node,
+        yaml_mark_t *start_mark, yaml_mark_t *end_mark)
+{
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(node > 0 && node <= document->count);
+                        /* Valid node id is required. */
+    assert(start_mark && end_mark);
+                        /* Non-NULL marks are expected. */
+
+    if (!document->start_marks) return 0;
+
+    *start_mark = document->start_marks[node-1];
+    *end_mark = document->end_marks[node-1];
+
     return 1;
 }
 
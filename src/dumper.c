@@ -140,6 +140,7 @@ yaml_emitter_dump(yaml_emitter_t *emitter, yaml_document_t *document)
     DOCUMENT_START_EVENT_INIT(event, document->version_directive,
             document->tag_directives.start, document->tag_directives.end,
             document->start_implicit, mark, mark);
+    event.arena = (document->arena != NULL);
     if (!yaml_emitter_emit(emitter, &event)) goto error;
 
     yaml_emitter_anchor_node(emitter, 1);
@@ -168,8 +169,13 @@ yaml_emitter_delete_document_and_anchors(yaml_emitter_t *emitter)
 {
     int index;
 
-    if (!emitter->anchors) {
+    /* The strings of an arena document are not handed over to the events. */
+
+    if (!emitter->anchors || emitter->document->arena) {
+        yaml_free(emitter->anchors);
         yaml_document_delete(emitter->document);
+        emitter->anchors = NULL;
+        emitter->last_anchor_id = 0;
         emitter->document = NULL;
         return;
     }
@@ -188,6 +194,7 @@ yaml_emitter_delete_document_and_anchors(yaml_emitter_t *emitter)
         }
         if (node.type == YAML_MAPPING_NODE) {
             STACK_DEL(emitter, node.data.mapping.pairs);
+            yaml_free(node.data.mapping.index.start);
         }
     }
 
@@ -245,9 +252,10 @@ yaml_emitter_anchor_node(yaml_emitter_t *emitter, int index)
 #define ANCHOR_TEMPLATE_LENGTH  16
 
 static yaml_char_t *
-yaml_emitter_generate_anchor(SHIM(yaml_emitter_t *emitter), int anchor_id)
+yaml_emitter_generate_anchor(yaml_emitter_t *emitter, int anchor_id)
 {
-    yaml_char_t *anchor = YAML_MALLOC(ANCHOR_TEMPLATE_LENGTH);
+    yaml_char_t *anchor = (yaml_char_t *)DOCUMENT_MALLOC(emitter->document,
+            ANCHOR_TEMPLATE_LENGTH);
 
     if (!anchor) return NULL;
 
@@ -304,6 +312,7 @@ yaml_emitter_dump_alias(yaml_emitter_t *emitter, yaml_char_t *anchor)
     yaml_mark_t mark  = { 0, 0, 0 };
 
     ALIAS_EVENT_INIT(event, anchor, mark, mark);
+    event.arena = (emitter->document->arena != NULL);
 
     return yaml_emitter_emit(emitter, &event);
 }
@@ -327,6 +336,7 @@ yaml_emitter_dump_scalar(yaml_emitter_t *emitter, yaml_node_t *node,
     SCALAR_EVENT_INIT(event, anchor, node->tag, node->data.scalar.value,
             node->data.scalar.length, plain_implicit, quoted_implicit,
             node->data.scalar.style, mark, mark);
+    event.arena = (emitter->document->arena != NULL);
 
     return yaml_emitter_emit(emitter, &event);
 }
@@ -348,6 +358,7 @@ yaml_emitter_dump_sequence(yaml_emitter_t *emitter, yaml_node_t *node,
 
     SEQUENCE_START_EVENT_INIT(event, anchor, node->tag, implicit,
             node->data.sequence.style, mark, mark);
+    event.arena = (emitter->document->arena != NULL);
     if (!yaml_emitter_emit(emitter, &event)) return 0;
 
     for (item = node->data.sequence.items.start;
@@ -378,6 +389,7 @@ yaml_emitter_dump_mapping(yaml_emitter_t *emitter, yaml_node_t *node,
 
     MAPPING_START_EVENT_INIT(event, anchor, node->tag, implicit,
             node->data.mapping.style, mark, mark);
+    event.arena = (emitter->document->arena != NULL);
     if (!yaml_emitter_emit(emitter, &event)) return 0;
 
     for (pair = node->data.mapping.pairs.start;
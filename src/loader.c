@@ -8,6 +8,10 @@
 YAML_DECLARE(int)
 yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document);
 
+YAML_DECLARE(int)
+yaml_parser_load_compact(yaml_parser_t *parser,
+        yaml_compact_document_t *document, int marks);
+
 /*
  * Error handling.
  */
@@ -28,7 +32,16 @@ yaml_parser_set_composer_error_context(yaml_parser_t *parser,
 
 static int
 yaml_parser_register_anchor(yaml_parser_t *parser,
-        int index, yaml_char_t *anchor);
+        int index, yaml_char_t *anchor, yaml_mark_t mark);
+
+static void
+yaml_parser_free_anchor(yaml_parser_t *parser, yaml_char_t *anchor);
+
+static size_t *
+yaml_parser_find_anchor(yaml_parser_t *parser, const yaml_char_t *anchor);
+
+static int
+yaml_parser_grow_anchors(yaml_parser_t *parser);
 
 /*
  * Clean up functions.
@@ -37,6 +50,29 @@ yaml_parser_register_anchor(yaml_parser_t *parser,
 static void
 yaml_parser_delete_aliases(yaml_parser_t *parser);
 
+/*
+ * Document storage.
+ */
+
+static yaml_char_t *
+yaml_parser_take_string(yaml_parser_t *parser, yaml_char_t *string,
+        size_t length, int borrowed);
+
+static int
+yaml_parser_take_directives(yaml_parser_t *parser, yaml_event_t *event);
+
+static int
+yaml_parser_append_item(yaml_parser_t *parser,
+        int sequence, yaml_node_item_t item);
+
+static int
+yaml_parser_append_pair(yaml_parser_t *parser,
+        int mapping, yaml_node_pair_t pair);
+
+static int
+yaml_parser_close_collection(yaml_parser_t *parser,
+        int index, size_t base);
+
 /*
  * Composer functions.
  */
@@ -59,6 +95,48 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *first_event);
 static int
 yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *first_event);
 
+/*
+ * Compact composer functions.
+ */
+
+static int
+yaml_parser_compact_document(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event);
+
+static int
+yaml_parser_compact_node(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event);
+
+static int
+yaml_parser_compact_scalar(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event);
+
+static int
+yaml_parser_compact_collection(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event);
+
+static int
+yaml_parser_add_compact_node(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_node_type_t type, int style,
+        yaml_char_t *tag, yaml_mark_t start_mark, yaml_mark_t end_mark);
+
+static int
+yaml_parser_intern_tag(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_char_t *tag,
+        yaml_node_type_t type);
+
+static int
+yaml_parser_grow_tag_index(yaml_parser_t *parser,
+        yaml_compact_document_t *document);
+
+static int
+yaml_parser_append_compact_string(yaml_parser_t *parser,
+        yaml_compact_document_t *document, const yaml_char_t *string,
+        size_t length, size_t *offset);
+
+static int
+yaml_parser_resize_compact(yaml_compact_document_t *document, int capacity);
+
 /*
  * Load the next document of the stream.
  */
@@ -70,6 +148,8 @@ yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document)
 
     assert(parser);     /* Non-NULL parser object is expected. */
     assert(document);   /* Non-NULL document object is expected. */
+    assert(!parser->arena || parser->document_arena);
+                        /* The document owns or copies the event strings. */
 
     memset(document, 0, sizeof(yaml_document_t));
     if (!STACK_INIT(parser, document->nodes, yaml_node_t*))
@@ -93,6 +173,24 @@ yaml_parser_load(yaml_parser_t *parser, yaml_document_t *document)
     if (!STACK_INIT(parser, parser->aliases, yaml_alias_data_t*))
         goto error;
 
+    if (parser->document_arena) {
+        document->arena = YAML_MALLOC_STATIC(struct yaml_arena_s);
+        if (!document->arena) {
+            parser->error = YAML_MEMORY_ERROR;
+            goto error;
+        }
+        memset(document->arena, 0, sizeof(struct yaml_arena_s));
+        document->arena->size = parser->document_arena;
+        if (!parser->items.start) {
+            if (!STACK_INIT(parser, parser->items, yaml_node_item_t*))
+                goto error;
+            if (!STACK_INIT(parser, parser->pairs, yaml_node_pair_t*))
+                goto error;
+        }
+        parser->items.top = parser->items.start;
+        parser->pairs.top = parser->pairs.start;
+    }
+
     parser->document = document;
 
     if (!yaml_parser_load_document(parser, &event)) goto error;
@@ -152,9 +250,220 @@ static void
 yaml_parser_delete_aliases(yaml_parser_t *parser)
 {
     while (!STACK_EMPTY(parser, parser->aliases)) {
-        yaml_free(POP(parser, parser->aliases).anchor);
+        yaml_parser_free_anchor(parser, POP(parser, parser->aliases).anchor);
     }
     STACK_DEL(parser, parser->aliases);
+    yaml_free(parser->anchors.start);
+    parser->anchors.start = parser->anchors.end = NULL;
+}
+
+/*
+ * Take over a string of an event for the document.
+ *
+ * The string is copied to the document arena if there is one, or to a new
+ * block if it is borrowed; otherwise the document keeps the string of the
+ * event.  A string that is not borrowed is given up even if the copy fails.
+ */
+
+static yaml_char_t *
+yaml_parser_take_string(yaml_parser_t *parser, yaml_char_t *string,
+        size_t length, int borrowed)
+{
+    yaml_char_t *copy;
+
+    if (!string || (!parser->document->arena && !borrowed))
+        return string;
+
+    copy = (yaml_char_t *)DOCUMENT_MALLOC(parser->document, length+1);
+    if (copy) {
+        memcpy(copy, string, length);
+        copy[length] = '\0';
+    }
+    else {
+        parser->error = YAML_MEMORY_ERROR;
+    }
+
+    if (!borrowed) {
+        ARENA_FREE(parser, string);
+    }
+
+    return copy;
+}
+
+/*
+ * Take over the directives of a DOCUMENT-START event for the document.
+ */
+
+static int
+yaml_parser_take_directives(yaml_parser_t *parser, yaml_event_t *event)
+{
+    yaml_document_t *document = parser->document;
+    yaml_version_directive_t *version_directive
+        = event->data.document_start.version_directive;
+    yaml_tag_directive_t *tag_directives_start
+        = event->data.document_start.tag_directives.start;
+    yaml_tag_directive_t *tag_directives_end
+        = event->data.document_start.tag_directives.end;
+    yaml_tag_directive_t *tag_directives;
+    yaml_tag_directive_t *tag_directive;
+    int failed = 0;
+
+    if (!document->arena) {
+        document->version_directive = version_directive;
+        document->tag_directives.start = tag_directives_start;
+        document->tag_directives.end = tag_directives_end;
+        return 1;
+    }
+
+    if (version_directive) {
+        document->version_directive = (yaml_version_directive_t *)
+            yaml_arena_malloc(document->arena, sizeof(*version_directive));
+        if (document->version_directive) {
+            *document->version_directive = *version_directive;
+        }
+        else {
+            failed = 1;
+        }
+        ARENA_FREE(parser, version_directive);
+    }
+
+    if (tag_directives_start != tag_directives_end) {
+        tag_directives = (yaml_tag_directive_t *)yaml_arena_malloc(
+                document->arena, (tag_directives_end - tag_directives_start)
+                * sizeof(*tag_directives));
+        if (!tag_directives) {
+            failed = 1;
+        }
+        for (tag_directive = tag_directives_start;
+                tag_directive != tag_directives_end; tag_directive ++) {
+            yaml_char_t *handle = yaml_parser_take_string(parser,
+                    tag_directive->handle,
+                    strlen((char *)tag_directive->handle), 0);
+            yaml_char_t *prefix = yaml_parser_take_string(parser,
+                    tag_directive->prefix,
+                    strlen((char *)tag_directive->prefix), 0);
+            if (!handle || !prefix) {
+                failed = 1;
+            }
+            if (tag_directives) {
+                tag_directives[tag_directive-tag_directives_start].handle
+                    = handle;
+                tag_directives[tag_directive-tag_directives_start].prefix
+                    = prefix;
+            }
+        }
+        ARENA_FREE(parser, tag_directives_start);
+        if (!failed) {
+            document->tag_directives.start = tag_directives;
+            document->tag_directives.end = tag_directives
+                + (tag_directives_end - tag_directives_start);
+        }
+    }
+
+    if (failed) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Append an item to a sequence node.
+ *
+ * The items of the open sequences of an arena document are collected in the
+ * parser until the sequence is closed.
+ */
+
+static int
+yaml_parser_append_item(yaml_parser_t *parser,
+        int sequence, yaml_node_item_t item)
+{
+    if (parser->document->arena) {
+        if (!STACK_LIMIT(parser, parser->items, INT_MAX-1)) return 0;
+        return PUSH(parser, parser->items, item);
+    }
+
+    if (!STACK_LIMIT(parser,
+                parser->document->nodes.start[sequence-1].data.sequence.items,
+                INT_MAX-1)) return 0;
+    return PUSH(parser,
+            parser->document->nodes.start[sequence-1].data.sequence.items,
+            item);
+}
+
+/*
+ * Append a pair to a mapping node.
+ *
+ * The pairs of the open mappings of an arena document are collected in the
+ * parser until the mapping is closed.
+ */
+
+static int
+yaml_parser_append_pair(yaml_parser_t *parser,
+        int mapping, yaml_node_pair_t pair)
+{
+    if (parser->document->arena) {
+        if (!STACK_LIMIT(parser, parser->pairs, INT_MAX-1)) return 0;
+        return PUSH(parser, parser->pairs, pair);
+    }
+
+    if (!STACK_LIMIT(parser,
+                parser->document->nodes.start[mapping-1].data.mapping.pairs,
+                INT_MAX-1)) return 0;
+    return PUSH(parser,
+            parser->document->nodes.start[mapping-1].data.mapping.pairs,
+            pair);
+}
+
+/*
+ * Move the items or pairs of a collection of an arena document, which start
+ * at the given position of the stack of the parser, to a block of the arena.
+ */
+
+static int
+yaml_parser_close_collection(yaml_parser_t *parser,
+        int index, size_t base)
+{
+    yaml_node_t *node = parser->document->nodes.start + index-1;
+    size_t count;
+
+    if (!parser->document->arena) return 1;
+
+    if (node->type == YAML_SEQUENCE_NODE) {
+        count = (parser->items.top - parser->items.start) - base;
+        if (count) {
+            yaml_node_item_t *items = (yaml_node_item_t *)yaml_arena_malloc(
+                    parser->document->arena, count*sizeof(*items));
+            if (!items) {
+                parser->error = YAML_MEMORY_ERROR;
+                return 0;
+            }
+            memcpy(items, parser->items.start + base, count*sizeof(*items));
+            node->data.sequence.items.start = items;
+            node->data.sequence.items.end = items + count;
+            node->data.sequence.items.top = items + count;
+        }
+        parser->items.top = parser->items.start + base;
+    }
+    else {
+        count = (parser->pairs.top - parser->pairs.start) - base;
+        if (count) {
+            yaml_node_pair_t *pairs = (yaml_node_pair_t *)yaml_arena_malloc(
+                    parser->document->arena, count*sizeof(*pairs));
+            if (!pairs) {
+                parser->error = YAML_MEMORY_ERROR;
+                return 0;
+            }
+            memcpy(pairs, parser->pairs.start + base, count*sizeof(*pairs));
+            node->data.mapping.pairs.start = pairs;
+            node->data.mapping.pairs.end = pairs + count;
+            node->data.mapping.pairs.top = pairs + count;
+        }
+        parser->pairs.top = parser->pairs.start + base;
+    }
+
+    return 1;
 }
 
 /*
@@ -169,12 +478,8 @@ yaml_parser_load_document(yaml_parser_t *parser, yaml_event_t *first_event)
     assert(first_event->type == YAML_DOCUMENT_START_EVENT);
                         /* DOCUMENT-START is expected. */
 
-    parser->document->version_directive
-        = first_event->data.document_start.version_directive;
-    parser->document->tag_directives.start
-        = first_event->data.document_start.tag_directives.start;
-    parser->document->tag_directives.end
-        = first_event->data.document_start.tag_directives.end;
+    if (!yaml_parser_take_directives(parser, first_event)) return 0;
+
     parser->document->start_implicit
         = first_event->data.document_start.implicit;
     parser->document->start_mark = first_event->start_mark;
@@ -223,31 +528,114 @@ yaml_parser_load_node(yaml_parser_t *parser, yaml_event_t *first_event)
 
 static int
 yaml_parser_register_anchor(yaml_parser_t *parser,
-        int index, yaml_char_t *anchor)
+        int index, yaml_char_t *anchor, yaml_mark_t mark)
 {
     yaml_alias_data_t data;
-    yaml_alias_data_t *alias_data;
+    size_t *slot;
 
     if (!anchor) return 1;
 
     data.anchor = anchor;
     data.index = index;
-    data.mark = parser->document->nodes.start[index-1].start_mark;
+    data.mark = mark;
 
-    for (alias_data = parser->aliases.start;
-            alias_data != parser->aliases.top; alias_data ++) {
-        if (strcmp((char *)alias_data->anchor, (char *)anchor) == 0) {
-            yaml_free(anchor);
-            return yaml_parser_set_composer_error_context(parser,
-                    "found duplicate anchor; first occurrence",
-                    alias_data->mark, "second occurrence", data.mark);
+    /* Keep the table at most half full. */
+
+    if ((size_t)(parser->aliases.top - parser->aliases.start + 1)*2
+            > (size_t)(parser->anchors.end - parser->anchors.start)) {
+        if (!yaml_parser_grow_anchors(parser)) {
+            yaml_parser_free_anchor(parser, anchor);
+            return 0;
         }
     }
 
+    slot = yaml_parser_find_anchor(parser, anchor);
+
+    if (*slot) {
+        yaml_parser_free_anchor(parser, anchor);
+        return yaml_parser_set_composer_error_context(parser,
+                "found duplicate anchor; first occurrence",
+                parser->aliases.start[*slot-1].mark, "second occurrence",
+                data.mark);
+    }
+
     if (!PUSH(parser, parser->aliases, data)) {
+        yaml_parser_free_anchor(parser, anchor);
+        return 0;
+    }
+
+    *slot = parser->aliases.top - parser->aliases.start;
+
+    return 1;
+}
+
+/*
+ * Free an anchor, which lives in the arena of the document if it has one.
+ */
+
+static void
+yaml_parser_free_anchor(yaml_parser_t *parser, yaml_char_t *anchor)
+{
+    if (!parser->document || !parser->document->arena) {
         yaml_free(anchor);
+    }
+}
+
+/*
+ * Find the slot of an anchor in the hash table of the anchors, or the empty
+ * slot where it belongs.
+ *
+ * The table is searched linearly from the FNV-1a hash of the anchor.  It must
+ * not be empty.
+ */
+
+static size_t *
+yaml_parser_find_anchor(yaml_parser_t *parser, const yaml_char_t *anchor)
+{
+    size_t mask = (parser->anchors.end - parser->anchors.start) - 1;
+    size_t hash = yaml_hash(anchor, strlen((char *)anchor));
+
+    for (hash &= mask; parser->anchors.start[hash]; hash = (hash+1) & mask) {
+        yaml_alias_data_t *alias_data
+            = parser->aliases.start + parser->anchors.start[hash]-1;
+        if (strcmp((char *)alias_data->anchor, (char *)anchor) == 0)
+            break;
+    }
+
+    return parser->anchors.start + hash;
+}
+
+/*
+ * Double the hash table of the anchors and insert the anchors anew.
+ */
+
+static int
+yaml_parser_grow_anchors(yaml_parser_t *parser)
+{
+    size_t size = parser->anchors.start
+        ? (parser->anchors.end - parser->anchors.start)*2 : INITIAL_TABLE_SIZE;
+    yaml_alias_data_t *alias_data;
+
+    if (size > (size_t)-1 / sizeof(size_t)) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    yaml_free(parser->anchors.start);
+    parser->anchors.start = (size_t *)yaml_malloc(size*sizeof(size_t));
+    if (!parser->anchors.start) {
+        parser->anchors.end = NULL;
+        parser->error = YAML_MEMORY_ERROR;
         return 0;
     }
+    memset(parser->anchors.start, 0, size*sizeof(size_t));
+    parser->anchors.end = parser->anchors.start + size;
+
+    for (alias_data = parser->aliases.start;
+            alias_data != parser->aliases.top; alias_data ++) {
+        *yaml_parser_find_anchor(parser, alias_data->anchor)
+            = alias_data - parser->aliases.start + 1;
+    }
 
     return 1;
 }
@@ -260,17 +648,17 @@ static int
 yaml_parser_load_alias(yaml_parser_t *parser, yaml_event_t *first_event)
 {
     yaml_char_t *anchor = first_event->data.alias.anchor;
-    yaml_alias_data_t *alias_data;
+    size_t *slot;
 
-    for (alias_data = parser->aliases.start;
-            alias_data != parser->aliases.top; alias_data ++) {
-        if (strcmp((char *)alias_data->anchor, (char *)anchor) == 0) {
-            yaml_free(anchor);
-            return alias_data->index;
+    if (parser->anchors.start) {
+        slot = yaml_parser_find_anchor(parser, anchor);
+        if (*slot) {
+            ARENA_FREE(parser, anchor);
+            return parser->aliases.start[*slot-1].index;
         }
     }
 
-    yaml_free(anchor);
+    ARENA_FREE(parser, anchor);
     return yaml_parser_set_composer_error(parser, "found undefined alias",
             first_event->start_mark);
 }
@@ -285,32 +673,48 @@ yaml_parser_load_scalar(yaml_parser_t *parser, yaml_event_t *first_event)
     yaml_node_t node;
     int index;
     yaml_char_t *tag = first_event->data.scalar.tag;
+    yaml_char_t *anchor = first_event->data.scalar.anchor;
+    yaml_char_t *value = first_event->data.scalar.value;
+    size_t length = first_event->data.scalar.length;
+
+    /* A document outlives the input, so a borrowed value is copied. */
+
+    tag = yaml_parser_take_string(parser, tag,
+            tag ? strlen((char *)tag) : 0, 0);
+    anchor = yaml_parser_take_string(parser, anchor,
+            anchor ? strlen((char *)anchor) : 0, 0);
+    value = yaml_parser_take_string(parser, value, length,
+            first_event->data.scalar.borrowed);
+    if ((first_event->data.scalar.tag && !tag)
+            || (first_event->data.scalar.anchor && !anchor) || !value)
+        goto error;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
     if (!tag || strcmp((char *)tag, "!") == 0) {
-        yaml_free(tag);
-        tag = yaml_strdup((yaml_char_t *)YAML_DEFAULT_SCALAR_TAG);
+        DOCUMENT_FREE(parser->document, tag);
+        tag = yaml_parser_take_string(parser,
+                (yaml_char_t *)YAML_DEFAULT_SCALAR_TAG,
+                strlen(YAML_DEFAULT_SCALAR_TAG), 1);
         if (!tag) goto error;
     }
 
-    SCALAR_NODE_INIT(node, tag, first_event->data.scalar.value,
-            first_event->data.scalar.length, first_event->data.scalar.style,
+    SCALAR_NODE_INIT(node, tag, value, length, first_event->data.scalar.style,
             first_event->start_mark, first_event->end_mark);
 
     if (!PUSH(parser, parser->document->nodes, node)) goto error;
 
     index = parser->document->nodes.top - parser->document->nodes.start;
 
-    if (!yaml_parser_register_anchor(parser, index,
-                first_event->data.scalar.anchor)) return 0;
+    if (!yaml_parser_register_anchor(parser, index, anchor,
+                first_event->start_mark)) return 0;
 
     return index;
 
 error:
-    yaml_free(tag);
-    yaml_free(first_event->data.scalar.anchor);
-    yaml_free(first_event->data.scalar.value);
+    DOCUMENT_FREE(parser->document, tag);
+    DOCUMENT_FREE(parser->document, anchor);
+    DOCUMENT_FREE(parser->document, value);
     return 0;
 }
 
@@ -329,17 +733,32 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *first_event)
         yaml_node_item_t *top;
     } items = { NULL, NULL, NULL };
     int index, item_index;
+    size_t base = parser->items.top - parser->items.start;
     yaml_char_t *tag = first_event->data.sequence_start.tag;
+    yaml_char_t *anchor = first_event->data.sequence_start.anchor;
+
+    tag = yaml_parser_take_string(parser, tag,
+            tag ? strlen((char *)tag) : 0, 0);
+    anchor = yaml_parser_take_string(parser, anchor,
+            anchor ? strlen((char *)anchor) : 0, 0);
+    if ((first_event->data.sequence_start.tag && !tag)
+            || (first_event->data.sequence_start.anchor && !anchor))
+        goto error;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
     if (!tag || strcmp((char *)tag, "!") == 0) {
-        yaml_free(tag);
-        tag = yaml_strdup((yaml_char_t *)YAML_DEFAULT_SEQUENCE_TAG);
+        DOCUMENT_FREE(parser->document, tag);
+        tag = yaml_parser_take_string(parser,
+                (yaml_char_t *)YAML_DEFAULT_SEQUENCE_TAG,
+                strlen(YAML_DEFAULT_SEQUENCE_TAG), 1);
         if (!tag) goto error;
     }
 
-    if (!STACK_INIT(parser, items, yaml_node_item_t*)) goto error;
+    /* The items of an arena document are collected in the parser. */
+
+    if (!parser->document->arena
+            && !STACK_INIT(parser, items, yaml_node_item_t*)) goto error;
 
     SEQUENCE_NODE_INIT(node, tag, items.start, items.end,
             first_event->data.sequence_start.style,
@@ -349,30 +768,28 @@ yaml_parser_load_sequence(yaml_parser_t *parser, yaml_event_t *first_event)
 
     index = parser->document->nodes.top - parser->document->nodes.start;
 
-    if (!yaml_parser_register_anchor(parser, index,
-                first_event->data.sequence_start.anchor)) return 0;
+    if (!yaml_parser_register_anchor(parser, index, anchor,
+                first_event->start_mark)) return 0;
 
     if (!yaml_parser_parse(parser, &event)) return 0;
 
     while (event.type != YAML_SEQUENCE_END_EVENT) {
-        if (!STACK_LIMIT(parser,
-                    parser->document->nodes.start[index-1].data.sequence.items,
-                    INT_MAX-1)) return 0;
         item_index = yaml_parser_load_node(parser, &event);
         if (!item_index) return 0;
-        if (!PUSH(parser,
-                    parser->document->nodes.start[index-1].data.sequence.items,
-                    item_index)) return 0;
+        if (!yaml_parser_append_item(parser, index, item_index)) return 0;
         if (!yaml_parser_parse(parser, &event)) return 0;
     }
 
+    if (!yaml_parser_close_collection(parser, index, base)) return 0;
+
     parser->document->nodes.start[index-1].end_mark = event.end_mark;
 
     return index;
 
 error:
-    yaml_free(tag);
-    yaml_free(first_event->data.sequence_start.anchor);
+    STACK_DEL(parser, items);
+    DOCUMENT_FREE(parser->document, tag);
+    DOCUMENT_FREE(parser->document, anchor);
     return 0;
 }
 
@@ -391,18 +808,33 @@ yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *first_event)
         yaml_node_pair_t *top;
     } pairs = { NULL, NULL, NULL };
     int index;
+    size_t base = parser->pairs.top - parser->pairs.start;
     yaml_node_pair_t pair;
     yaml_char_t *tag = first_event->data.mapping_start.tag;
+    yaml_char_t *anchor = first_event->data.mapping_start.anchor;
+
+    tag = yaml_parser_take_string(parser, tag,
+            tag ? strlen((char *)tag) : 0, 0);
+    anchor = yaml_parser_take_string(parser, anchor,
+            anchor ? strlen((char *)anchor) : 0, 0);
+    if ((first_event->data.mapping_start.tag && !tag)
+            || (first_event->data.mapping_start.anchor && !anchor))
+        goto error;
 
     if (!STACK_LIMIT(parser, parser->document->nodes, INT_MAX-1)) goto error;
 
     if (!tag || strcmp((char *)tag, "!") == 0) {
-        yaml_free(tag);
-        tag = yaml_strdup((yaml_char_t *)YAML_DEFAULT_MAPPING_TAG);
+        DOCUMENT_FREE(parser->document, tag);
+        tag = yaml_parser_take_string(parser,
+                (yaml_char_t *)YAML_DEFAULT_MAPPING_TAG,
+                strlen(YAML_DEFAULT_MAPPING_TAG), 1);
         if (!tag) goto error;
     }
 
-    if (!STACK_INIT(parser, pairs, yaml_node_pair_t*)) goto error;
+    /* The pairs of an arena document are collected in the parser. */
+
+    if (!parser->document->arena
+            && !STACK_INIT(parser, pairs, yaml_node_pair_t*)) goto error;
 
     MAPPING_NODE_INIT(node, tag, pairs.start, pairs.end,
             first_event->data.mapping_start.style,
@@ -412,33 +844,501 @@ yaml_parser_load_mapping(yaml_parser_t *parser, yaml_event_t *first_event)
 
     index = parser->document->nodes.top - parser->document->nodes.start;
 
-    if (!yaml_parser_register_anchor(parser, index,
-                first_event->data.mapping_start.anchor)) return 0;
+    if (!yaml_parser_register_anchor(parser, index, anchor,
+                first_event->start_mark)) return 0;
 
     if (!yaml_parser_parse(parser, &event)) return 0;
 
     while (event.type != YAML_MAPPING_END_EVENT) {
-        if (!STACK_LIMIT(parser,
-                    parser->document->nodes.start[index-1].data.mapping.pairs,
-                    INT_MAX-1)) return 0;
         pair.key = yaml_parser_load_node(parser, &event);
         if (!pair.key) return 0;
         if (!yaml_parser_parse(parser, &event)) return 0;
         pair.value = yaml_parser_load_node(parser, &event);
         if (!pair.value) return 0;
-        if (!PUSH(parser,
-                    parser->document->nodes.start[index-1].data.mapping.pairs,
-                    pair)) return 0;
+        if (!yaml_parser_append_pair(parser, index, pair)) return 0;
         if (!yaml_parser_parse(parser, &event)) return 0;
     }
 
+    if (!yaml_parser_close_collection(parser, index, base)) return 0;
+
     parser->document->nodes.start[index-1].end_mark = event.end_mark;
 
     return index;
 
 error:
-    yaml_free(tag);
-    yaml_free(first_event->data.mapping_start.anchor);
+    STACK_DEL(parser, pairs);
+    DOCUMENT_FREE(parser->document, tag);
+    DOCUMENT_FREE(parser->document, anchor);
     return 0;
 }
 
+/*
+ * Load the next document of the stream in the compact form.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_load_compact(yaml_parser_t *parser,
+        yaml_compact_document_t *document, int marks)
+{
+    yaml_event_t event;
+
+    assert(parser);     /* Non-NULL parser object is expected. */
+    assert(document);   /* Non-NULL document object is expected. */
+    assert(!parser->arena); /* The document owns the event directives. */
+
+    memset(document, 0, sizeof(yaml_compact_document_t));
+    document->marks = marks;
+
+    if (!parser->stream_start_produced) {
+        if (!yaml_parser_parse(parser, &event)) goto error;
+        assert(event.type == YAML_STREAM_START_EVENT);
+                        /* STREAM-START is expected. */
+    }
+
+    if (parser->stream_end_produced) {
+        return 1;
+    }
+
+    if (!yaml_parser_parse(parser, &event)) goto error;
+    if (event.type == YAML_STREAM_END_EVENT) {
+        return 1;
+    }
+
+    if (!STACK_INIT(parser, parser->aliases, yaml_alias_data_t*))
+        goto error;
+    if (!parser->items.start
+            && !STACK_INIT(parser, parser->items, yaml_node_item_t*))
+        goto error;
+    parser->items.top = parser->items.start;
+    if (!STRING_INIT(parser, document->strings, INITIAL_STRING_SIZE))
+        goto error;
+    if (!STACK_INIT(parser, document->children, int*))
+        goto error;
+    if (!STACK_INIT(parser, document->tag_list, size_t*))
+        goto error;
+
+    if (!yaml_parser_compact_document(parser, document, &event)) goto error;
+
+    yaml_parser_delete_aliases(parser);
+    yaml_free(parser->tag_index.start);
+    parser->tag_index.start = parser->tag_index.end = NULL;
+
+    /* Give back the unused parts of the arrays. */
+
+    if (yaml_parser_resize_compact(document, document->count)) {
+        document->capacity = document->count;
+    }
+    if (document->children.top != document->children.start) {
+        void *children = yaml_realloc(document->children.start,
+                (char *)document->children.top
+                - (char *)document->children.start);
+        if (children) {
+            document->children.top = (int *)children
+                + (document->children.top - document->children.start);
+            document->children.start = (int *)children;
+            document->children.end = document->children.top;
+        }
+    }
+    if (document->strings.pointer != document->strings.end) {
+        yaml_char_t *strings = (yaml_char_t *)yaml_realloc(
+                document->strings.start,
+                document->strings.pointer - document->strings.start);
+        if (strings) {
+            document->strings.pointer = strings
+                + (document->strings.pointer - document->strings.start);
+            document->strings.start = strings;
+            document->strings.end = document->strings.pointer;
+        }
+    }
+
+    return 1;
+
+error:
+
+    yaml_parser_delete_aliases(parser);
+    yaml_free(parser->tag_index.start);
+    parser->tag_index.start = parser->tag_index.end = NULL;
+    yaml_compact_document_delete(document);
+
+    return 0;
+}
+
+/*
+ * Compose a compact document object.
+ */
+
+static int
+yaml_parser_compact_document(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event)
+{
+    yaml_event_t event;
+
+    assert(first_event->type == YAML_DOCUMENT_START_EVENT);
+                        /* DOCUMENT-START is expected. */
+
+    document->version_directive
+        = first_event->data.document_start.version_directive;
+    document->tag_directives.start
+        = first_event->data.document_start.tag_directives.start;
+    document->tag_directives.end
+        = first_event->data.document_start.tag_directives.end;
+    document->start_implicit = first_event->data.document_start.implicit;
+    document->start_mark = first_event->start_mark;
+
+    if (!yaml_parser_parse(parser, &event)) return 0;
+
+    if (!yaml_parser_compact_node(parser, document, &event)) return 0;
+
+    if (!yaml_parser_parse(parser, &event)) return 0;
+    assert(event.type == YAML_DOCUMENT_END_EVENT);
+                        /* DOCUMENT-END is expected. */
+
+    document->end_implicit = event.data.document_end.implicit;
+    document->end_mark = event.end_mark;
+
+    return 1;
+}
+
+/*
+ * Compose a compact node.
+ */
+
+static int
+yaml_parser_compact_node(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event)
+{
+    switch (first_event->type) {
+        case YAML_ALIAS_EVENT:
+            return yaml_parser_load_alias(parser, first_event);
+        case YAML_SCALAR_EVENT:
+            return yaml_parser_compact_scalar(parser, document, first_event);
+        case YAML_SEQUENCE_START_EVENT:
+        case YAML_MAPPING_START_EVENT:
+            return yaml_parser_compact_collection(parser, document,
+                    first_event);
+        default:
+            assert(0);  /* Could not happen. */
+            return 0;
+    }
+
+    return 0;
+}
+
+/*
+ * Compose a compact scalar node.
+ */
+
+static int
+yaml_parser_compact_scalar(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event)
+{
+    yaml_char_t *anchor = first_event->data.scalar.anchor;
+    yaml_char_t *value = first_event->data.scalar.value;
+    size_t length = first_event->data.scalar.length;
+    int index;
+
+    index = yaml_parser_add_compact_node(parser, document, YAML_SCALAR_NODE,
+            first_event->data.scalar.style, first_event->data.scalar.tag,
+            first_event->start_mark, first_event->end_mark);
+
+    if (index) {
+        document->lengths[index-1] = length;
+        if (!yaml_parser_append_compact_string(parser, document, value,
+                    length, document->offsets + index-1))
+            index = 0;
+    }
+
+    if (!first_event->data.scalar.borrowed) {
+        yaml_free(value);
+    }
+
+    if (!index) {
+        yaml_free(anchor);
+        return 0;
+    }
+
+    if (!yaml_parser_register_anchor(parser, index, anchor,
+                first_event->start_mark)) return 0;
+
+    return index;
+}
+
+/*
+ * Compose a compact sequence or mapping node.
+ *
+ * The children of the open collections are collected in the parser, and the
+ * children of a collection are moved to the document when it ends, so that
+ * they take a single range of the children array.
+ */
+
+static int
+yaml_parser_compact_collection(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_event_t *first_event)
+{
+    yaml_event_t event;
+    int sequence = (first_event->type == YAML_SEQUENCE_START_EVENT);
+    yaml_char_t *anchor = sequence ? first_event->data.sequence_start.anchor
+        : first_event->data.mapping_start.anchor;
+    size_t base = parser->items.top - parser->items.start;
+    size_t count;
+    int index, child;
+
+    index = yaml_parser_add_compact_node(parser, document,
+            sequence ? YAML_SEQUENCE_NODE : YAML_MAPPING_NODE,
+            sequence ? (int)first_event->data.sequence_start.style
+                : (int)first_event->data.mapping_start.style,
+            sequence ? first_event->data.sequence_start.tag
+                : first_event->data.mapping_start.tag,
+            first_event->start_mark, first_event->end_mark);
+
+    if (!index) {
+        yaml_free(anchor);
+        return 0;
+    }
+
+    if (!yaml_parser_register_anchor(parser, index, anchor,
+                first_event->start_mark)) return 0;
+
+    if (!yaml_parser_parse(parser, &event)) return 0;
+
+    while (event.type != YAML_SEQUENCE_END_EVENT
+            && event.type != YAML_MAPPING_END_EVENT) {
+        child = yaml_parser_compact_node(parser, document, &event);
+        if (!child) return 0;
+        if (!STACK_LIMIT(parser, parser->items, INT_MAX-1)) return 0;
+        if (!PUSH(parser, parser->items, child)) return 0;
+        if (!yaml_parser_parse(parser, &event)) return 0;
+    }
+
+    count = (parser->items.top - parser->items.start) - base;
+
+    while ((size_t)(document->children.end - document->children.top)
+            < count) {
+        if (!yaml_stack_extend((void **)&document->children.start,
+                    (void **)&document->children.top,
+                    (void **)&document->children.end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    memcpy(document->children.top, parser->items.start + base,
+            count*sizeof(int));
+    document->offsets[index-1]
+        = document->children.top - document->children.start;
+    document->lengths[index-1] = count;
+    document->children.top += count;
+    parser->items.top = parser->items.start + base;
+
+    if (document->marks) {
+        document->end_marks[index-1] = event.end_mark;
+    }
+
+    return index;
+}
+
+/*
+ * Add a node to a compact document and return its id.
+ *
+ * The tag of the event is freed in any case.
+ */
+
+static int
+yaml_parser_add_compact_node(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_node_type_t type, int style,
+        yaml_char_t *tag, yaml_mark_t start_mark, yaml_mark_t end_mark)
+{
+    int index = document->count;
+    int tag_id;
+
+    if (index == document->capacity) {
+        int capacity = index ? index*2 : INITIAL_STACK_SIZE;
+        if (index >= INT_MAX/2
+                || !yaml_parser_resize_compact(document, capacity)) {
+            yaml_free(tag);
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        document->capacity = capacity;
+    }
+
+    tag_id = yaml_parser_intern_tag(parser, document, tag, type);
+    if (tag_id < 0) return 0;
+
+    document->types[index] = (unsigned char)type;
+    document->styles[index] = (unsigned char)style;
+    document->tags[index] = tag_id;
+    document->offsets[index] = 0;
+    document->lengths[index] = 0;
+    if (document->marks) {
+        document->start_marks[index] = start_mark;
+        document->end_marks[index] = end_mark;
+    }
+
+    return ++ document->count;
+}
+
+/*
+ * Intern the tag of a node and return its id, or -1 on error.
+ *
+ * A missing or non-specific tag is replaced with the default tag of the node
+ * type.  The tag of the event is freed in any case.
+ */
+
+static int
+yaml_parser_intern_tag(yaml_parser_t *parser,
+        yaml_compact_document_t *document, yaml_char_t *tag,
+        yaml_node_type_t type)
+{
+    const yaml_char_t *name = tag;
+    size_t length, mask, hash;
+    size_t offset;
+    int id;
+
+    if (!tag || strcmp((char *)tag, "!") == 0) {
+        name = (const yaml_char_t *)(type == YAML_SCALAR_NODE
+                ? YAML_DEFAULT_SCALAR_TAG : type == YAML_SEQUENCE_NODE
+                ? YAML_DEFAULT_SEQUENCE_TAG : YAML_DEFAULT_MAPPING_TAG);
+    }
+    length = strlen((char *)name);
+
+    /* Keep the table at most half full. */
+
+    if ((size_t)(document->tag_list.top - document->tag_list.start + 1)*2
+            > (size_t)(parser->tag_index.end - parser->tag_index.start)) {
+        if (!yaml_parser_grow_tag_index(parser, document)) {
+            yaml_free(tag);
+            return -1;
+        }
+    }
+
+    mask = (parser->tag_index.end - parser->tag_index.start) - 1;
+    for (hash = yaml_hash(name, length) & mask; parser->tag_index.start[hash];
+            hash = (hash+1) & mask) {
+        id = parser->tag_index.start[hash]-1;
+        if (strcmp((char *)document->strings.start
+                    + document->tag_list.start[id], (char *)name) == 0) {
+            yaml_free(tag);
+            return id;
+        }
+    }
+
+    if (!STACK_LIMIT(parser, document->tag_list, INT_MAX-1)
+            || !yaml_parser_append_compact_string(parser, document,
+                name, length, &offset)
+            || !PUSH(parser, document->tag_list, offset)) {
+        yaml_free(tag);
+        return -1;
+    }
+
+    id = document->tag_list.top - document->tag_list.start;
+    parser->tag_index.start[hash] = id;
+
+    yaml_free(tag);
+    return id-1;
+}
+
+/*
+ * Double the hash table of the tags and insert the tags anew.
+ */
+
+static int
+yaml_parser_grow_tag_index(yaml_parser_t *parser,
+        yaml_compact_document_t *document)
+{
+    size_t size = parser->tag_index.start
+        ? (parser->tag_index.end - parser->tag_index.start)*2
+        : INITIAL_TABLE_SIZE;
+    size_t mask = size-1;
+    size_t *offset;
+
+    if (size > (size_t)-1 / sizeof(int)) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    yaml_free(parser->tag_index.start);
+    parser->tag_index.start = (int *)yaml_malloc(size*sizeof(int));
+    if (!parser->tag_index.start) {
+        parser->tag_index.end = NULL;
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+    memset(parser->tag_index.start, 0, size*sizeof(int));
+    parser->tag_index.end = parser->tag_index.start + size;
+
+    for (offset = document->tag_list.start;
+            offset != document->tag_list.top; offset ++) {
+        const yaml_char_t *name = document->strings.start + *offset;
+        size_t hash = yaml_hash(name, strlen((char *)name)) & mask;
+        while (parser->tag_index.start[hash]) {
+            hash = (hash+1) & mask;
+        }
+        parser->tag_index.start[hash] = offset - document->tag_list.start + 1;
+    }
+
+    return 1;
+}
+
+/*
+ * Append a string followed by a NUL character to the strings of a compact
+ * document.
+ */
+
+static int
+yaml_parser_append_compact_string(yaml_parser_t *parser,
+        yaml_compact_document_t *document, const yaml_char_t *string,
+        size_t length, size_t *offset)
+{
+    while ((size_t)(document->strings.end - document->strings.pointer)
+            <= length) {
+        if (!yaml_string_extend(&document->strings.start,
+                    &document->strings.pointer, &document->strings.end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    *offset = document->strings.pointer - document->strings.start;
+    memcpy(document->strings.pointer, string, length);
+    document->strings.pointer[length] = '\0';
+    document->strings.pointer += length+1;
+
+    return 1;
+}
+
+/*
+ * Resize the node arrays of a compact document.
+ */
+
+static int
+yaml_parser_resize_compact(yaml_compact_document_t *document, int capacity)
+{
+    void *types, *styles, *tags, *offsets, *lengths;
+    void *start_marks = NULL, *end_marks = NULL;
+
+    if (!capacity) return 0;
+
+    types = yaml_realloc(document->types, capacity);
+    if (types) document->types = (unsigned char *)types;
+    styles = yaml_realloc(document->styles, capacity);
+    if (styles) document->styles = (unsigned char *)styles;
+    tags = yaml_realloc(document->tags, capacity*sizeof(int));
+    if (tags) document->tags = (int *)tags;
+    offsets = yaml_realloc(document->offsets, capacity*sizeof(size_t));
+    if (offsets) document->offsets = (size_t *)offsets;
+    lengths = yaml_realloc(document->lengths, capacity*sizeof(size_t));
+    if (lengths) document->lengths = (size_t *)lengths;
+
+    if (document->marks) {
+        start_marks = yaml_realloc(document->start_marks,
+                capacity*sizeof(yaml_mark_t));
+        if (start_marks) document->start_marks = (yaml_mark_t *)start_marks;
+        end_marks = yaml_realloc(document->end_marks,
+                capacity*sizeof(yaml_mark_t));
+        if (end_marks) document->end_marks = (yaml_mark_t *)end_marks;
+        if (!start_marks || !end_marks) return 0;
+    }
+
+    return (types && styles && tags && offsets && lengths);
+}
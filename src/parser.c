@@ -54,7 +54,7 @@
  */
 
 #define SKIP_TOKEN(parser)                                                      \
-    (parser->token_available = 0,                                               \
+    (parser->token_available --,                                                \
      parser->tokens_parsed ++,                                                  \
      parser->stream_end_produced =                                              \
         (parser->tokens.head->type == YAML_STREAM_END_TOKEN),                   \
@@ -67,6 +67,10 @@
 YAML_DECLARE(int)
 yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event);
 
+YAML_DECLARE(int)
+yaml_parser_parse_batch(yaml_parser_t *parser, yaml_event_t *events,
+        size_t max, size_t *count, int document);
+
 /*
  * Error handling.
  */
@@ -87,6 +91,9 @@ yaml_parser_set_parser_error_context(yaml_parser_t *parser,
 static int
 yaml_parser_state_machine(yaml_parser_t *parser, yaml_event_t *event);
 
+static int
+yaml_parser_parse_pushed(yaml_parser_t *parser, yaml_event_t *event);
+
 static int
 yaml_parser_parse_stream_start(yaml_parser_t *parser, yaml_event_t *event);
 
@@ -169,6 +176,8 @@ yaml_parser_append_tag_directive(yaml_parser_t *parser,
 YAML_DECLARE(int)
 yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event)
 {
+    int result;
+
     assert(parser);     /* Non-NULL parser object is expected. */
     assert(event);      /* Non-NULL event object is expected. */
 
@@ -176,6 +185,12 @@ yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event)
 
     memset(event, 0, sizeof(yaml_event_t));
 
+    /* Release the strings of the previous events. */
+
+    if (parser->arena) {
+        yaml_parser_release_arena(parser);
+    }
+
     /* No events after the end of the stream or error. */
 
     if (parser->stream_end_produced || parser->error ||
@@ -185,7 +200,117 @@ yaml_parser_parse(yaml_parser_t *parser, yaml_event_t *event)
 
     /* Generate the next event. */
 
-    return yaml_parser_state_machine(parser, event);
+    if (parser->read_handler == yaml_feed_read_handler)
+        result = yaml_parser_parse_pushed(parser, event);
+    else
+        result = yaml_parser_state_machine(parser, event);
+
+    event->arena = (parser->arena != NULL);
+
+    return result;
+}
+
+/*
+ * Get the next events.
+ */
+
+YAML_DECLARE(int)
+yaml_parser_parse_batch(yaml_parser_t *parser, yaml_event_t *events,
+        size_t max, size_t *count, int document)
+{
+    int pushed;
+    int result = 1;
+
+    assert(parser);     /* Non-NULL parser object is expected. */
+    assert(events || !max); /* Non-NULL event array is expected. */
+    assert(count);      /* Non-NULL count is expected. */
+
+    pushed = (parser->read_handler == yaml_feed_read_handler);
+
+    /* Release the strings of the previous events. */
+
+    if (parser->arena) {
+        yaml_parser_release_arena(parser);
+    }
+
+    for (*count = 0; *count < max; (*count) ++)
+    {
+        yaml_event_t *event = events + *count;
+
+        /* No events after the end of the stream or error. */
+
+        if (parser->stream_end_produced || parser->error ||
+                parser->state == YAML_PARSE_END_STATE)
+            break;
+
+        /* Generate the next event. */
+
+        result = pushed ? yaml_parser_parse_pushed(parser, event)
+            : yaml_parser_state_machine(parser, event);
+
+        if (result != 1)
+            break;
+
+        event->arena = (parser->arena != NULL);
+
+        /* Stop at the end of a document if asked to. */
+
+        if (document && event->type == YAML_DOCUMENT_END_EVENT) {
+            (*count) ++;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Generate the next event from a pushed input.
+ *
+ * If the input runs out in the middle of the event, the parser returns to
+ * where the event started: the skipped tokens are still in the queue, and the
+ * state functions change nothing else but push onto the stacks before they
+ * are done peeking.  The stacks may be reallocated meanwhile, so their depths
+ * are saved rather than their tops.
+ */
+
+static int
+yaml_parser_parse_pushed(yaml_parser_t *parser, yaml_event_t *event)
+{
+    size_t head;
+    size_t tokens_parsed = parser->tokens_parsed;
+    size_t token_available = parser->token_available;
+    int stream_end_produced = parser->stream_end_produced;
+    yaml_parser_state_t state = parser->state;
+    size_t states = parser->states.top - parser->states.start;
+    size_t marks = parser->marks.top - parser->marks.start;
+    size_t tag_directives = parser->tag_directives.top
+        - parser->tag_directives.start;
+
+    yaml_parser_compact_tokens(parser);
+    head = parser->tokens.head - parser->tokens.start;
+
+    if (yaml_parser_state_machine(parser, event))
+        return 1;
+
+    if (parser->error)
+        return 0;
+
+    parser->tokens.head = parser->tokens.start + head;
+    parser->tokens_parsed = tokens_parsed;
+    parser->token_available = token_available;
+    parser->stream_end_produced = stream_end_produced;
+    parser->state = state;
+    parser->states.top = parser->states.start + states;
+    parser->marks.top = parser->marks.start + marks;
+    while (parser->tag_directives.top
+            != parser->tag_directives.start + tag_directives) {
+        yaml_tag_directive_t tag_directive = POP(parser, parser->tag_directives);
+        yaml_free(tag_directive.handle);
+        yaml_free(tag_directive.prefix);
+    }
+
+    return YAML_PARSER_NEED_MORE_INPUT;
 }
 
 /*
@@ -420,13 +545,13 @@ yaml_parser_parse_document_start(yaml_parser_t *parser, yaml_event_t *event,
     }
 
 error:
-    yaml_free(version_directive);
+    ARENA_FREE(parser, version_directive);
     while (tag_directives.start != tag_directives.end) {
-        yaml_free(tag_directives.end[-1].handle);
-        yaml_free(tag_directives.end[-1].prefix);
+        ARENA_FREE(parser, tag_directives.end[-1].handle);
+        ARENA_FREE(parser, tag_directives.end[-1].prefix);
         tag_directives.end --;
     }
-    yaml_free(tag_directives.start);
+    ARENA_FREE(parser, tag_directives.start);
     return 0;
 }
 
@@ -594,7 +719,7 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
         if (tag_handle) {
             if (!*tag_handle) {
                 tag = tag_suffix;
-                yaml_free(tag_handle);
+                ARENA_FREE(parser, tag_handle);
                 tag_handle = tag_suffix = NULL;
             }
             else {
@@ -605,7 +730,7 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
                     if (strcmp((char *)tag_directive->handle, (char *)tag_handle) == 0) {
                         size_t prefix_len = strlen((char *)tag_directive->prefix);
                         size_t suffix_len = strlen((char *)tag_suffix);
-                        tag = YAML_MALLOC(prefix_len+suffix_len+1);
+                        tag = ARENA_MALLOC(parser, prefix_len+suffix_len+1);
                         if (!tag) {
                             parser->error = YAML_MEMORY_ERROR;
                             goto error;
@@ -613,8 +738,8 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
                         memcpy(tag, tag_directive->prefix, prefix_len);
                         memcpy(tag+prefix_len, tag_suffix, suffix_len);
                         tag[prefix_len+suffix_len] = '\0';
-                        yaml_free(tag_handle);
-                        yaml_free(tag_suffix);
+                        ARENA_FREE(parser, tag_handle);
+                        ARENA_FREE(parser, tag_suffix);
                         tag_handle = tag_suffix = NULL;
                         break;
                     }
@@ -653,6 +778,7 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
                         token->data.scalar.value, token->data.scalar.length,
                         plain_implicit, quoted_implicit,
                         token->data.scalar.style, start_mark, end_mark);
+                event->data.scalar.borrowed = token->data.scalar.borrowed;
                 SKIP_TOKEN(parser);
                 return 1;
             }
@@ -685,7 +811,7 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
                 return 1;
             }
             else if (anchor || tag) {
-                yaml_char_t *value = YAML_MALLOC(1);
+                yaml_char_t *value = ARENA_MALLOC(parser, 1);
                 if (!value) {
                     parser->error = YAML_MEMORY_ERROR;
                     goto error;
@@ -708,10 +834,14 @@ yaml_parser_parse_node(yaml_parser_t *parser, yaml_event_t *event,
     }
 
 error:
-    yaml_free(anchor);
-    yaml_free(tag_handle);
-    yaml_free(tag_suffix);
-    yaml_free(tag);
+    /* If a pushed input runs out, the tokens still own the strings. */
+
+    if (parser->error) {
+        ARENA_FREE(parser, anchor);
+        ARENA_FREE(parser, tag_handle);
+        ARENA_FREE(parser, tag_suffix);
+    }
+    ARENA_FREE(parser, tag);
 
     return 0;
 }
@@ -1208,7 +1338,7 @@ yaml_parser_process_empty_scalar(yaml_parser_t *parser, yaml_event_t *event,
 {
     yaml_char_t *value;
 
-    value = YAML_MALLOC(1);
+    value = ARENA_MALLOC(parser, 1);
     if (!value) {
         parser->error = YAML_MEMORY_ERROR;
         return 0;
@@ -1266,7 +1396,10 @@ yaml_parser_process_directives(yaml_parser_t *parser,
                         "found incompatible YAML document", token->start_mark);
                 goto error;
             }
-            version_directive = YAML_MALLOC_STATIC(yaml_version_directive_t);
+            version_directive = parser->arena ?
+                (yaml_version_directive_t *)yaml_arena_malloc(parser->arena,
+                    sizeof(yaml_version_directive_t)) :
+                YAML_MALLOC_STATIC(yaml_version_directive_t);
             if (!version_directive) {
                 parser->error = YAML_MEMORY_ERROR;
                 goto error;
@@ -1307,6 +1440,20 @@ yaml_parser_process_directives(yaml_parser_t *parser,
             *tag_directives_start_ref = *tag_directives_end_ref = NULL;
             STACK_DEL(parser, tag_directives);
         }
+        else if (parser->arena) {
+            size_t size = (char *)tag_directives.top
+                - (char *)tag_directives.start;
+            *tag_directives_start_ref = (yaml_tag_directive_t *)
+                yaml_arena_malloc(parser->arena, size);
+            if (!*tag_directives_start_ref) {
+                parser->error = YAML_MEMORY_ERROR;
+                goto error;
+            }
+            memcpy(*tag_directives_start_ref, tag_directives.start, size);
+            *tag_directives_end_ref = *tag_directives_start_ref
+                + (tag_directives.top - tag_directives.start);
+            STACK_DEL(parser, tag_directives);
+        }
         else {
             *tag_directives_start_ref = tag_directives.start;
             *tag_directives_end_ref = tag_directives.top;
@@ -1317,15 +1464,15 @@ yaml_parser_process_directives(yaml_parser_t *parser,
     }
 
     if (!version_directive_ref)
-        yaml_free(version_directive);
+        ARENA_FREE(parser, version_directive);
     return 1;
 
 error:
-    yaml_free(version_directive);
-    while (!STACK_EMPTY(parser, tag_directives)) {
+    ARENA_FREE(parser, version_directive);
+    while (parser->error && !STACK_EMPTY(parser, tag_directives)) {
         yaml_tag_directive_t tag_directive = POP(parser, tag_directives);
-        yaml_free(tag_directive.handle);
-        yaml_free(tag_directive.prefix);
+        ARENA_FREE(parser, tag_directive.handle);
+        ARENA_FREE(parser, tag_directive.prefix);
     }
     STACK_DEL(parser, tag_directives);
     return 0;
@@ -15,6 +15,49 @@ yaml_parser_update_raw_buffer(yaml_parser_t *parser);
 static int
 yaml_parser_determine_encoding(yaml_parser_t *parser);
 
+static int
+yaml_parser_read_utf8(yaml_parser_t *parser);
+
+static int
+yaml_parser_keep_checkpoint(yaml_parser_t *parser);
+
+static size_t
+yaml_parser_ascii_span(const unsigned char *pointer, size_t length,
+        int avx2);
+
+static size_t
+yaml_parser_utf8_width(const unsigned char *pointer, size_t length);
+
+static size_t
+yaml_parser_utf8_span(const unsigned char *pointer, size_t length,
+        size_t *characters);
+
+static size_t
+yaml_parser_utf16_ascii_span(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output, int avx2);
+
+static size_t
+yaml_parser_utf16_span(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output, size_t *size,
+        size_t *characters);
+
+static void
+yaml_parser_release_mapping(yaml_parser_t *parser,
+        const unsigned char *pointer);
+
+static int
+yaml_parser_validate_string(const unsigned char *start,
+        const unsigned char *end, size_t *characters);
+
+static void
+yaml_parser_borrow_string(yaml_parser_t *parser);
+
+static int
+yaml_parser_extend_string(yaml_parser_t *parser);
+
+static void
+yaml_parser_return_string(yaml_parser_t *parser);
+
 YAML_DECLARE(int)
 yaml_parser_update_buffer(yaml_parser_t *parser, size_t length);
 
@@ -105,6 +148,13 @@ yaml_parser_update_raw_buffer(yaml_parser_t *parser)
 
     if (parser->eof) return 1;
 
+    /* Suspend if a pushed input runs out before its end. */
+
+    if (parser->read_handler == yaml_feed_read_handler
+            && parser->input.feed.pointer == parser->input.feed.last
+            && !parser->input.feed.final)
+        return 0;
+
     /* Move the remaining bytes in the raw buffer to the beginning. */
 
     if (parser->raw_buffer.start < parser->raw_buffer.pointer
@@ -131,6 +181,808 @@ yaml_parser_update_raw_buffer(yaml_parser_t *parser)
     return 1;
 }
 
+/*
+ * Read a UTF-8 input directly into the working buffer.
+ *
+ * The raw buffer is bypassed: the valid characters are left where they are
+ * read, and only the octets that need the decoder are moved to the raw
+ * buffer.  The read size is the same as for the raw buffer, so the errors
+ * are reported at the same points.
+ */
+
+static int
+yaml_parser_read_utf8(yaml_parser_t *parser)
+{
+    size_t size_read = 0;
+    size_t size;
+    size_t characters;
+
+    assert(parser->raw_buffer.pointer == parser->raw_buffer.last);
+
+    /* Suspend if a pushed input runs out before its end. */
+
+    if (parser->read_handler == yaml_feed_read_handler
+            && parser->input.feed.pointer == parser->input.feed.last
+            && !parser->input.feed.final)
+        return 0;
+
+    parser->raw_buffer.pointer = parser->raw_buffer.start;
+    parser->raw_buffer.last = parser->raw_buffer.start;
+
+    if (!parser->read_handler(parser->read_handler_data, parser->buffer.last,
+                parser->raw_buffer.end - parser->raw_buffer.start, &size_read)) {
+        return yaml_parser_set_reader_error(parser, "input error",
+                parser->offset, -1);
+    }
+    if (!size_read) {
+        parser->eof = 1;
+        return 1;
+    }
+
+    size = yaml_parser_utf8_span(parser->buffer.last, size_read, &characters);
+
+    if (size < size_read) {
+        memcpy(parser->raw_buffer.start, parser->buffer.last+size,
+                size_read-size);
+        parser->raw_buffer.last += size_read-size;
+    }
+
+    parser->buffer.last += size;
+    parser->offset += size;
+    parser->unread += characters;
+    parser->decoded += characters;
+
+    return 1;
+}
+
+/*
+ * Check if an ASCII octet is an allowed character (#x9 | #xA | #xD |
+ * [#x20-#x7E]).
+ */
+
+#define IS_ALLOWED_ASCII(octet)                                                 \
+    (((octet) >= 0x20 && (octet) <= 0x7E)                                       \
+     || (octet) == 0x09 || (octet) == 0x0A || (octet) == 0x0D)
+
+/*
+ * Vectorized versions of the ASCII scan.  Each of them consumes whole blocks
+ * of allowed ASCII characters and stops at the first block containing
+ * anything else; the caller finishes the scan octet by octet.
+ */
+
+#if defined(YAML_HAVE_SSE2)
+
+static size_t
+yaml_parser_ascii_span_sse2(const unsigned char *pointer, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i tab = _mm_set1_epi8(0x09);
+    const __m128i lf = _mm_set1_epi8(0x0A);
+    const __m128i cr = _mm_set1_epi8(0x0D);
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        __m128i octets = _mm_loadu_si128((const __m128i *)(pointer+k));
+
+        /* Signed comparison: the octets above #x7F are negative. */
+
+        __m128i bad = _mm_andnot_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(octets, tab),
+                    _mm_or_si128(_mm_cmpeq_epi8(octets, lf),
+                        _mm_cmpeq_epi8(octets, cr))),
+                _mm_cmplt_epi8(octets, space));
+
+        bad = _mm_or_si128(bad, _mm_cmpeq_epi8(octets, del));
+
+        if (_mm_movemask_epi8(bad))
+            break;
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_AVX2)
+
+/*
+ * Check whether the CPU supports AVX2.  The answer is detected once; parsers
+ * running in several threads at once may detect it twice, with the same
+ * result.
+ */
+
+static int
+yaml_parser_has_avx2(void)
+{
+    static int avx2 = -1;
+
+    if (avx2 < 0) {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+
+    return avx2;
+}
+
+__attribute__((target("avx2")))
+static size_t
+yaml_parser_ascii_span_avx2(const unsigned char *pointer, size_t length)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    const __m256i tab = _mm256_set1_epi8(0x09);
+    const __m256i lf = _mm256_set1_epi8(0x0A);
+    const __m256i cr = _mm256_set1_epi8(0x0D);
+    size_t k = 0;
+
+    for (; k + 32 <= length; k += 32)
+    {
+        __m256i octets = _mm256_loadu_si256((const __m256i *)(pointer+k));
+
+        __m256i bad = _mm256_andnot_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(octets, tab),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(octets, lf),
+                        _mm256_cmpeq_epi8(octets, cr))),
+                _mm256_cmpgt_epi8(space, octets));
+
+        bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(octets, del));
+
+        if (_mm256_movemask_epi8(bad))
+            break;
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_NEON)
+
+static size_t
+yaml_parser_ascii_span_neon(const unsigned char *pointer, size_t length)
+{
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    const uint8x16_t tab = vdupq_n_u8(0x09);
+    const uint8x16_t lf = vdupq_n_u8(0x0A);
+    const uint8x16_t cr = vdupq_n_u8(0x0D);
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        uint8x16_t octets = vld1q_u8(pointer+k);
+        uint8x16_t bad = vbicq_u8(vcltq_u8(octets, space),
+                vorrq_u8(vceqq_u8(octets, tab),
+                    vorrq_u8(vceqq_u8(octets, lf), vceqq_u8(octets, cr))));
+        uint64x2_t lanes;
+
+        bad = vorrq_u8(bad, vcgeq_u8(octets, del));
+        lanes = vreinterpretq_u64_u8(bad);
+
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+            break;
+    }
+
+    return k;
+}
+
+#endif
+
+/*
+ * Return the length of the run of allowed ASCII characters at the beginning
+ * of the octet sequence.
+ */
+
+static size_t
+yaml_parser_ascii_span(const unsigned char *pointer, size_t length,
+        SHIM(int avx2))
+{
+    size_t k = 0;
+
+    UNUSED_PARAM(avx2)
+
+#if defined(YAML_HAVE_AVX2)
+    if (avx2)
+        k = yaml_parser_ascii_span_avx2(pointer, length);
+#endif
+#if defined(YAML_HAVE_SSE2)
+    k += yaml_parser_ascii_span_sse2(pointer+k, length-k);
+#elif defined(YAML_HAVE_NEON)
+    k += yaml_parser_ascii_span_neon(pointer+k, length-k);
+#endif
+
+    while (k < length && IS_ALLOWED_ASCII(pointer[k]))
+        k ++;
+
+    return k;
+}
+
+/*
+ * Return the width of a well-formed multibyte UTF-8 character that is allowed
+ * in the input stream, or 0 if the character is invalid, incomplete, or not
+ * allowed.  The latter cases are left to the decoder, which reports them.
+ */
+
+static size_t
+yaml_parser_utf8_width(const unsigned char *pointer, size_t length)
+{
+    unsigned char octet = pointer[0];
+    unsigned int value;
+    size_t width = (octet & 0xE0) == 0xC0 ? 2 :
+                   (octet & 0xF0) == 0xE0 ? 3 :
+                   (octet & 0xF8) == 0xF0 ? 4 : 0;
+    size_t k;
+
+    if (!width || width > length)
+        return 0;
+
+    value = octet & (0x7F >> width);
+
+    for (k = 1; k < width; k ++) {
+        if ((pointer[k] & 0xC0) != 0x80)
+            return 0;
+        value = (value << 6) + (pointer[k] & 0x3F);
+    }
+
+    /*
+     * Reject overlong sequences, surrogates and the characters outside of
+     * the allowed ranges: #x85 | [#xA0-#xD7FF] | [#xE000-#xFFFD] |
+     * [#x10000-#x10FFFF].
+     */
+
+    switch (width) {
+        case 2:
+            return (value == 0x85 || value >= 0xA0) ? 2 : 0;
+        case 3:
+            return ((value >= 0x800 && value <= 0xD7FF)
+                    || (value >= 0xE000 && value <= 0xFFFD)) ? 3 : 0;
+        default:
+            return (value >= 0x10000 && value <= 0x10FFFF) ? 4 : 0;
+    }
+}
+
+/*
+ * Return the length of the run of well-formed and allowed UTF-8 characters at
+ * the beginning of the octet sequence.  The number of characters in the run
+ * is stored to `characters`.
+ *
+ * The run may be copied to the buffer as is.  It stops before the first
+ * character that needs the decoder, so the errors are reported at the same
+ * offsets as without the fast path.
+ */
+
+static size_t
+yaml_parser_utf8_span(const unsigned char *pointer, size_t length,
+        size_t *characters)
+{
+    size_t k = 0;
+    size_t count = 0;
+    int avx2 = 0;
+
+#if defined(YAML_HAVE_AVX2)
+    if (length >= 32)
+        avx2 = yaml_parser_has_avx2();
+#endif
+
+    while (k < length)
+    {
+        if (pointer[k] < 0x80) {
+            size_t run = yaml_parser_ascii_span(pointer+k, length-k, avx2);
+            if (!run) break;
+            k += run;
+            count += run;
+        }
+        else {
+            size_t width = yaml_parser_utf8_width(pointer+k, length-k);
+            if (!width) break;
+            k += width;
+            count ++;
+        }
+    }
+
+    *characters = count;
+
+    return k;
+}
+
+/*
+ * Vectorized versions of the UTF-16 ASCII conversion.  Each of them converts
+ * whole blocks of allowed ASCII characters, narrowing the code units to
+ * octets, and stops at the first block containing anything else.  The length
+ * and the result are in input octets.
+ */
+
+#if defined(YAML_HAVE_SSE2)
+
+static size_t
+yaml_parser_utf16_ascii_span_sse2(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output)
+{
+    const __m128i space = _mm_set1_epi16(0x20);
+    const __m128i tilde = _mm_set1_epi16(0x7E);
+    const __m128i tab = _mm_set1_epi16(0x09);
+    const __m128i lf = _mm_set1_epi16(0x0A);
+    const __m128i cr = _mm_set1_epi16(0x0D);
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        __m128i units = _mm_loadu_si128((const __m128i *)(pointer+k));
+        __m128i bad;
+
+        if (big_endian) {
+            units = _mm_or_si128(_mm_slli_epi16(units, 8),
+                    _mm_srli_epi16(units, 8));
+        }
+
+        /* Signed comparison: the units above #x7FFF are negative. */
+
+        bad = _mm_andnot_si128(
+                _mm_or_si128(_mm_cmpeq_epi16(units, tab),
+                    _mm_or_si128(_mm_cmpeq_epi16(units, lf),
+                        _mm_cmpeq_epi16(units, cr))),
+                _mm_cmplt_epi16(units, space));
+
+        bad = _mm_or_si128(bad, _mm_cmpgt_epi16(units, tilde));
+
+        if (_mm_movemask_epi8(bad))
+            break;
+
+        _mm_storel_epi64((__m128i *)(output+k/2), _mm_packus_epi16(units, units));
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_AVX2)
+
+__attribute__((target("avx2")))
+static size_t
+yaml_parser_utf16_ascii_span_avx2(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output)
+{
+    const __m256i space = _mm256_set1_epi16(0x20);
+    const __m256i tilde = _mm256_set1_epi16(0x7E);
+    const __m256i tab = _mm256_set1_epi16(0x09);
+    const __m256i lf = _mm256_set1_epi16(0x0A);
+    const __m256i cr = _mm256_set1_epi16(0x0D);
+    size_t k = 0;
+
+    for (; k + 32 <= length; k += 32)
+    {
+        __m256i units = _mm256_loadu_si256((const __m256i *)(pointer+k));
+        __m256i bad;
+
+        if (big_endian) {
+            units = _mm256_or_si256(_mm256_slli_epi16(units, 8),
+                    _mm256_srli_epi16(units, 8));
+        }
+
+        bad = _mm256_andnot_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi16(units, tab),
+                    _mm256_or_si256(_mm256_cmpeq_epi16(units, lf),
+                        _mm256_cmpeq_epi16(units, cr))),
+                _mm256_cmpgt_epi16(space, units));
+
+        bad = _mm256_or_si256(bad, _mm256_cmpgt_epi16(units, tilde));
+
+        if (_mm256_movemask_epi8(bad))
+            break;
+
+        /* The packing works within the 128-bit lanes; join the halves. */
+
+        _mm_storeu_si128((__m128i *)(output+k/2), _mm256_castsi256_si128(
+                    _mm256_permute4x64_epi64(
+                        _mm256_packus_epi16(units, units), 0xD8)));
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_NEON)
+
+static size_t
+yaml_parser_utf16_ascii_span_neon(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output)
+{
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    const uint8x16_t tab = vdupq_n_u8(0x09);
+    const uint8x16_t lf = vdupq_n_u8(0x0A);
+    const uint8x16_t cr = vdupq_n_u8(0x0D);
+    size_t k = 0;
+
+    for (; k + 32 <= length; k += 32)
+    {
+        /* Split the units into the low and the high octets. */
+
+        uint8x16x2_t units = vld2q_u8(pointer+k);
+        uint8x16_t low = units.val[big_endian ? 1 : 0];
+        uint8x16_t high = units.val[big_endian ? 0 : 1];
+        uint8x16_t bad = vbicq_u8(vcltq_u8(low, space),
+                vorrq_u8(vceqq_u8(low, tab),
+                    vorrq_u8(vceqq_u8(low, lf), vceqq_u8(low, cr))));
+        uint64x2_t lanes;
+
+        bad = vorrq_u8(bad, vorrq_u8(vcgeq_u8(low, del), high));
+        lanes = vreinterpretq_u64_u8(bad);
+
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+            break;
+
+        vst1q_u8(output+k/2, low);
+    }
+
+    return k;
+}
+
+#endif
+
+/*
+ * Convert the run of allowed ASCII characters at the beginning of a UTF-16
+ * sequence to octets.  Return the length of the run in input octets.
+ */
+
+static size_t
+yaml_parser_utf16_ascii_span(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output, SHIM(int avx2))
+{
+    int low = big_endian ? 1 : 0;
+    int high = big_endian ? 0 : 1;
+    size_t k = 0;
+
+    UNUSED_PARAM(avx2)
+
+#if defined(YAML_HAVE_AVX2)
+    if (avx2)
+        k = yaml_parser_utf16_ascii_span_avx2(pointer, length, big_endian,
+                output);
+#endif
+#if defined(YAML_HAVE_SSE2)
+    k += yaml_parser_utf16_ascii_span_sse2(pointer+k, length-k, big_endian,
+            output+k/2);
+#elif defined(YAML_HAVE_NEON)
+    k += yaml_parser_utf16_ascii_span_neon(pointer+k, length-k, big_endian,
+            output+k/2);
+#endif
+
+    while (k + 2 <= length && !pointer[k+high]
+            && IS_ALLOWED_ASCII(pointer[k+low])) {
+        output[k/2] = pointer[k+low];
+        k += 2;
+    }
+
+    return k;
+}
+
+/*
+ * Convert the run of well-formed and allowed UTF-16 characters at the
+ * beginning of the octet sequence to UTF-8.  Return the length of the run in
+ * input octets; the number of output octets is stored to `size` and the
+ * number of characters to `characters`.
+ *
+ * Surrogate pairs are converted in the run as long as both halves are
+ * present.  The run stops before the first character that needs the decoder,
+ * so the errors are reported at the same offsets as without the fast path.
+ */
+
+static size_t
+yaml_parser_utf16_span(const unsigned char *pointer, size_t length,
+        int big_endian, unsigned char *output, size_t *size,
+        size_t *characters)
+{
+    int low = big_endian ? 1 : 0;
+    int high = big_endian ? 0 : 1;
+    unsigned char *last = output;
+    size_t k = 0;
+    size_t count = 0;
+    int avx2 = 0;
+
+#if defined(YAML_HAVE_AVX2)
+    if (length >= 64)
+        avx2 = yaml_parser_has_avx2();
+#endif
+
+    while (k + 2 <= length)
+    {
+        unsigned int value = pointer[k+low] + (pointer[k+high] << 8);
+
+        if (value < 0x80)
+        {
+            size_t run = yaml_parser_utf16_ascii_span(pointer+k, length-k,
+                    big_endian, last, avx2);
+            if (!run) break;
+            k += run;
+            last += run/2;
+            count += run/2;
+            continue;
+        }
+
+        if (value < 0x800)
+        {
+            if (value != 0x85 && value < 0xA0) break;
+            *(last++) = 0xC0 + (value >> 6);
+            *(last++) = 0x80 + (value & 0x3F);
+            k += 2;
+        }
+        else if ((value & 0xF800) != 0xD800)
+        {
+            if (value > 0xFFFD) break;
+            *(last++) = 0xE0 + (value >> 12);
+            *(last++) = 0x80 + ((value >> 6) & 0x3F);
+            *(last++) = 0x80 + (value & 0x3F);
+            k += 2;
+        }
+        else
+        {
+            unsigned int value2;
+
+            if ((value & 0xFC00) != 0xD800 || k + 4 > length) break;
+            value2 = pointer[k+2+low] + (pointer[k+2+high] << 8);
+            if ((value2 & 0xFC00) != 0xDC00) break;
+            value = 0x10000 + ((value & 0x3FF) << 10) + (value2 & 0x3FF);
+            *(last++) = 0xF0 + (value >> 18);
+            *(last++) = 0x80 + ((value >> 12) & 0x3F);
+            *(last++) = 0x80 + ((value >> 6) & 0x3F);
+            *(last++) = 0x80 + (value & 0x3F);
+            k += 4;
+        }
+
+        count ++;
+    }
+
+    *size = last - output;
+    *characters = count;
+
+    return k;
+}
+
+/*
+ * Release the pages of a memory-mapped input that lie before `pointer`.
+ *
+ * The mapping is private and never written, so a released page is read back
+ * from the file if it is touched again.  The pages are released in steps of
+ * INPUT_WINDOW_SIZE to keep the number of system calls low.
+ */
+
+static void
+yaml_parser_release_mapping(yaml_parser_t *parser,
+        const unsigned char *pointer)
+{
+#if HAVE_SYS_MMAN_H && defined(MADV_DONTNEED)
+    const unsigned char *resident = parser->mapping.resident;
+    size_t size;
+
+    if (!parser->mapping.start || pointer - resident < INPUT_WINDOW_SIZE)
+        return;
+
+    size = pointer - resident;
+    size -= size % (size_t)sysconf(_SC_PAGESIZE);
+
+    madvise((void *)resident, size, MADV_DONTNEED);
+    parser->mapping.resident = resident + size;
+#else
+    (void)parser;
+    (void)pointer;
+#endif
+}
+
+/*
+ * Check that a string input is valid UTF-8 and count its characters.
+ */
+
+static int
+yaml_parser_validate_string(const unsigned char *start,
+        const unsigned char *end, size_t *characters)
+{
+    const unsigned char *pointer = start;
+    size_t count = 0;
+
+    while (pointer != end)
+    {
+        size_t size = end - pointer;
+        size_t window;
+
+        if (size > INPUT_WINDOW_SIZE)
+            size = INPUT_WINDOW_SIZE;
+
+        /*
+         * The span stops before a character split by the window boundary,
+         * so an empty span means an invalid character.
+         */
+
+        size = yaml_parser_utf8_span(pointer, size, &window);
+        if (!size)
+            return 0;
+
+        pointer += size;
+        count += window;
+    }
+
+    *characters = count;
+
+    return 1;
+}
+
+/*
+ * Use a UTF-8 string input as the working buffer.
+ *
+ * The working buffer points directly into the input and neither the raw
+ * buffer nor the read handler is used until the end of the string.  If the
+ * input is not valid UTF-8, it is left to the decoder, which reports the
+ * error.
+ *
+ * A string is validated and handed to the scanner at once.  A memory-mapped
+ * file is validated and handed by windows, so its pages may be released
+ * behind the scanner.
+ */
+
+static void
+yaml_parser_borrow_string(yaml_parser_t *parser)
+{
+    const unsigned char *start = parser->input.string.current;
+    const unsigned char *end = parser->input.string.end;
+    yaml_encoding_t encoding = parser->encoding;
+    size_t characters;
+
+    /* Determine the encoding; only UTF-8 may be borrowed. */
+
+    if (!encoding) {
+        if (end - start >= 2 && (!memcmp(start, BOM_UTF16LE, 2)
+                    || !memcmp(start, BOM_UTF16BE, 2)))
+            return;
+        encoding = YAML_UTF8_ENCODING;
+        if (end - start >= 3 && !memcmp(start, BOM_UTF8, 3))
+            start += 3;
+    }
+
+    if (encoding != YAML_UTF8_ENCODING
+            || (size_t)(end - parser->input.string.start) >= MAX_FILE_SIZE)
+        return;
+
+    /* Validate the string; a mapped file is validated by windows. */
+
+    if (!parser->mapping.start
+            && !yaml_parser_validate_string(start, end, &characters))
+        return;
+
+    /* Put the allocated buffer aside and point the buffer into the input. */
+
+    parser->buffer_storage.start = parser->buffer.start;
+    parser->buffer_storage.end = parser->buffer.end;
+
+    parser->buffer.start = (yaml_char_t *)start;
+    parser->buffer.pointer = (yaml_char_t *)start;
+    parser->buffer.last = (yaml_char_t *)end;
+    parser->buffer.end = (yaml_char_t *)end;
+    parser->encoding = encoding;
+
+    if (parser->mapping.start) {
+        parser->buffer.last = (yaml_char_t *)start;
+        parser->offset += start - parser->input.string.current;
+        parser->input.string.current = start;
+        return;
+    }
+
+    parser->unread = characters;
+    parser->decoded += characters;
+    parser->offset += end - parser->input.string.current;
+    parser->input.string.current = end;
+}
+
+/*
+ * Validate the next window of a borrowed input and hand it to the scanner.
+ *
+ * Return 1 on success, 0 if the window starts with an invalid character.  The
+ * input position is then left at that character, so the decoder takes over
+ * from there and reports the error at the same offset.
+ */
+
+static int
+yaml_parser_extend_string(yaml_parser_t *parser)
+{
+    size_t size = parser->buffer.end - parser->buffer.last;
+    size_t characters;
+
+    if (size > INPUT_WINDOW_SIZE)
+        size = INPUT_WINDOW_SIZE;
+
+    /*
+     * The span stops before a character split by the window boundary, so an
+     * empty span means an invalid character.
+     */
+
+    size = yaml_parser_utf8_span(parser->buffer.last, size, &characters);
+    if (!size)
+        return 0;
+
+    parser->buffer.last += size;
+    parser->unread += characters;
+    parser->decoded += characters;
+    parser->offset += size;
+    parser->input.string.current = parser->buffer.last;
+
+    yaml_parser_release_mapping(parser, parser->buffer.pointer);
+
+    return 1;
+}
+
+/*
+ * Move the unread tail of a borrowed string input to the allocated buffer.
+ *
+ * This happens only at the end of the input or at an invalid character, so
+ * the tail is shorter than the requested lookahead.  The decoder then adds
+ * the terminating NUL or reports the error.
+ */
+
+static void
+yaml_parser_return_string(yaml_parser_t *parser)
+{
+    size_t size = parser->buffer.last - parser->buffer.pointer;
+
+    memcpy(parser->buffer_storage.start, parser->buffer.pointer, size);
+
+    parser->buffer.start = parser->buffer_storage.start;
+    parser->buffer.pointer = parser->buffer_storage.start;
+    parser->buffer.last = parser->buffer_storage.start + size;
+    parser->buffer.end = parser->buffer_storage.end;
+
+    parser->buffer_storage.start = NULL;
+    parser->buffer_storage.end = NULL;
+}
+
+/*
+ * Make room in the buffer for decoding the raw buffer, keeping the characters
+ * after the scanner checkpoint of a pushed input.
+ *
+ * The scanner returns to the checkpoint if the input runs out in the middle
+ * of a token, so the buffer grows to hold the longest token.
+ */
+
+static int
+yaml_parser_keep_checkpoint(yaml_parser_t *parser)
+{
+    yaml_char_t *checkpoint = parser->input.feed.checkpoint;
+    size_t size = parser->buffer.last - checkpoint;
+    size_t capacity = parser->buffer.end - parser->buffer.start;
+    yaml_char_t *start;
+
+    if ((size_t)(parser->buffer.end - parser->buffer.last)
+            >= INPUT_BUFFER_RESERVE)
+        return 1;
+
+    if (parser->buffer.start < checkpoint) {
+        memmove(parser->buffer.start, checkpoint, size);
+        parser->buffer.pointer -= checkpoint - parser->buffer.start;
+        parser->buffer.last = parser->buffer.start + size;
+        parser->input.feed.checkpoint = parser->buffer.start;
+    }
+
+    if (capacity - size >= INPUT_BUFFER_RESERVE)
+        return 1;
+
+    start = yaml_realloc(parser->buffer.start, capacity*2);
+    if (!start) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    parser->buffer.pointer = start + (parser->buffer.pointer
+            - parser->buffer.start);
+    parser->buffer.last = start + size;
+    parser->buffer.end = start + capacity*2;
+    parser->buffer.start = start;
+    parser->input.feed.checkpoint = start;
+
+    return 1;
+}
+
 /*
  * Ensure that the buffer contains at least `length` characters.
  * Return 1 on success, 0 on failure.
@@ -155,6 +1007,36 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
     if (parser->unread >= length)
         return 1;
 
+    /* Try to use a string input as the buffer when the reading starts. */
+
+    if (parser->read_handler == yaml_string_read_handler
+            && parser->input.string.current == parser->input.string.start
+            && !parser->buffer_storage.start) {
+        yaml_parser_borrow_string(parser);
+    }
+
+    /*
+     * Extend a borrowed string, and at its end or at an invalid character
+     * switch back to the allocated buffer.
+     */
+
+    if (parser->buffer_storage.start) {
+        while (parser->unread < length
+                && parser->buffer.last != parser->buffer.end) {
+            if (!yaml_parser_extend_string(parser))
+                break;
+        }
+        if (parser->unread >= length)
+            return 1;
+        yaml_parser_return_string(parser);
+    }
+
+    /* Release the pages of a memory-mapped input that are already read. */
+
+    if (parser->mapping.start) {
+        yaml_parser_release_mapping(parser, parser->input.string.current);
+    }
+
     /* Determine the input encoding if it is not known yet. */
 
     if (!parser->encoding) {
@@ -162,19 +1044,28 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
             return 0;
     }
 
-    /* Move the unread characters to the beginning of the buffer. */
+    /*
+     * Move the unread characters to the beginning of the buffer, unless there
+     * is still enough room for decoding the raw buffer after them.
+     */
 
-    if (parser->buffer.start < parser->buffer.pointer
-            && parser->buffer.pointer < parser->buffer.last) {
-        size_t size = parser->buffer.last - parser->buffer.pointer;
-        memmove(parser->buffer.start, parser->buffer.pointer, size);
-        parser->buffer.pointer = parser->buffer.start;
-        parser->buffer.last = parser->buffer.start + size;
+    if (parser->read_handler == yaml_feed_read_handler
+            && parser->input.feed.checkpoint) {
+        if (!yaml_parser_keep_checkpoint(parser))
+            return 0;
     }
     else if (parser->buffer.pointer == parser->buffer.last) {
         parser->buffer.pointer = parser->buffer.start;
         parser->buffer.last = parser->buffer.start;
     }
+    else if (parser->buffer.start < parser->buffer.pointer
+            && (size_t)(parser->buffer.end - parser->buffer.last)
+                < INPUT_BUFFER_RESERVE) {
+        size_t size = parser->buffer.last - parser->buffer.pointer;
+        memmove(parser->buffer.start, parser->buffer.pointer, size);
+        parser->buffer.pointer = parser->buffer.start;
+        parser->buffer.last = parser->buffer.start + size;
+    }
 
     /* Fill the buffer until it has enough characters. */
 
@@ -183,7 +1074,13 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
         /* Fill the raw buffer if necessary. */
 
         if (!first || parser->raw_buffer.pointer == parser->raw_buffer.last) {
-            if (!yaml_parser_update_raw_buffer(parser)) return 0;
+            if (parser->encoding == YAML_UTF8_ENCODING && !parser->eof
+                    && parser->raw_buffer.pointer == parser->raw_buffer.last) {
+                if (!yaml_parser_read_utf8(parser)) return 0;
+            }
+            else {
+                if (!yaml_parser_update_raw_buffer(parser)) return 0;
+            }
         }
         first = 0;
 
@@ -199,6 +1096,47 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
             size_t k;
             size_t raw_unread = parser->raw_buffer.last - parser->raw_buffer.pointer;
 
+            /*
+             * The UTF-8 input does not need to be re-encoded: copy the run of
+             * valid characters as is and use the decoder for the rest.
+             */
+
+            if (parser->encoding == YAML_UTF8_ENCODING)
+            {
+                size_t characters;
+                size_t run = yaml_parser_utf8_span(parser->raw_buffer.pointer,
+                        raw_unread, &characters);
+
+                if (run) {
+                    memcpy(parser->buffer.last, parser->raw_buffer.pointer, run);
+                    parser->buffer.last += run;
+                    parser->raw_buffer.pointer += run;
+                    parser->offset += run;
+                    parser->unread += characters;
+                    parser->decoded += characters;
+                    continue;
+                }
+            }
+
+            /* The UTF-16 input is converted by runs the same way. */
+
+            else
+            {
+                size_t size, characters;
+                size_t run = yaml_parser_utf16_span(parser->raw_buffer.pointer,
+                        raw_unread, parser->encoding == YAML_UTF16BE_ENCODING,
+                        parser->buffer.last, &size, &characters);
+
+                if (run) {
+                    parser->buffer.last += size;
+                    parser->raw_buffer.pointer += run;
+                    parser->offset += run;
+                    parser->unread += characters;
+                    parser->decoded += characters;
+                    continue;
+                }
+            }
+
             /* Decode the next character. */
 
             switch (parser->encoding)
@@ -448,6 +1386,7 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
             }
 
             parser->unread ++;
+            parser->decoded ++;
         }
 
         /* On EOF, put NUL into the buffer and return. */
@@ -455,6 +1394,7 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length)
         if (parser->eof) {
             *(parser->buffer.last++) = '\0';
             parser->unread ++;
+            parser->decoded ++;
             return 1;
         }
 
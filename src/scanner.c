@@ -487,29 +487,58 @@
         ? 1                                                                     \
         : yaml_parser_update_buffer(parser, (length)))
 
+/*
+ * The index and the column of the current position.  The index is the number
+ * of the characters put into the buffer less the unread ones, so only the
+ * line and the start of the line are updated while advancing.
+ */
+
+#define INDEX(parser)                                                           \
+    (parser->decoded - parser->unread)
+
+#define COLUMN(parser)                                                          \
+    (INDEX(parser) - parser->line_start)
+
+/*
+ * Update the index and the column of the current mark and return the mark.
+ */
+
+#define MARK(parser)                                                            \
+    (parser->mark.index = INDEX(parser),                                        \
+     parser->mark.column = parser->mark.index - parser->line_start,             \
+     parser->mark)
+
+/*
+ * Check if the JSON tokenizer is used at the current position.
+ */
+
+#define JSON_MODE(parser)                                                       \
+    (parser->flow_level && (parser->json_mode > 0                               \
+        || (!parser->json_mode && parser->json_root)))
+
 /*
  * Advance the buffer pointer.
  */
 
 #define SKIP(parser)                                                            \
-     (parser->mark.index ++,                                                    \
-      parser->mark.column ++,                                                   \
-      parser->unread --,                                                        \
+     (parser->unread --,                                                        \
       parser->buffer.pointer += WIDTH(parser->buffer))
 
+#define SKIP_ASCII(parser,length)                                               \
+     (parser->unread -= (length),                                               \
+      parser->buffer.pointer += (length))
+
 #define SKIP_LINE(parser)                                                       \
      (IS_CRLF(parser->buffer) ?                                                 \
-      (parser->mark.index += 2,                                                 \
-       parser->mark.column = 0,                                                 \
-       parser->mark.line ++,                                                    \
+      (parser->mark.line ++,                                                    \
        parser->unread -= 2,                                                     \
-       parser->buffer.pointer += 2) :                                           \
+       parser->buffer.pointer += 2,                                             \
+       parser->line_start = INDEX(parser)) :                                    \
       IS_BREAK(parser->buffer) ?                                                \
-      (parser->mark.index ++,                                                   \
-       parser->mark.column = 0,                                                 \
-       parser->mark.line ++,                                                    \
+      (parser->mark.line ++,                                                    \
        parser->unread --,                                                       \
-       parser->buffer.pointer += WIDTH(parser->buffer)) : 0)
+       parser->buffer.pointer += WIDTH(parser->buffer),                         \
+       parser->line_start = INDEX(parser)) : 0)
 
 /*
  * Copy a character to a string buffer and advance pointers.
@@ -518,8 +547,6 @@
 #define READ(parser,string)                                                     \
      (STRING_EXTEND(parser,string) ?                                            \
          (COPY(string,parser->buffer),                                          \
-          parser->mark.index ++,                                                \
-          parser->mark.column ++,                                               \
           parser->unread --,                                                    \
           1) : 0)
 
@@ -533,26 +560,23 @@
        && CHECK_AT(parser->buffer,'\n',1)) ?        /* CR LF -> LF */           \
      (*((string).pointer++) = (yaml_char_t) '\n',                               \
       parser->buffer.pointer += 2,                                              \
-      parser->mark.index += 2,                                                  \
-      parser->mark.column = 0,                                                  \
+      parser->unread -= 2,                                                      \
       parser->mark.line ++,                                                     \
-      parser->unread -= 2) :                                                    \
+      parser->line_start = INDEX(parser)) :                                     \
      (CHECK_AT(parser->buffer,'\r',0)                                           \
       || CHECK_AT(parser->buffer,'\n',0)) ?         /* CR|LF -> LF */           \
      (*((string).pointer++) = (yaml_char_t) '\n',                               \
       parser->buffer.pointer ++,                                                \
-      parser->mark.index ++,                                                    \
-      parser->mark.column = 0,                                                  \
+      parser->unread --,                                                        \
       parser->mark.line ++,                                                     \
-      parser->unread --) :                                                      \
+      parser->line_start = INDEX(parser)) :                                     \
      (CHECK_AT(parser->buffer,'\xC2',0)                                         \
       && CHECK_AT(parser->buffer,'\x85',1)) ?       /* NEL -> LF */             \
      (*((string).pointer++) = (yaml_char_t) '\n',                               \
       parser->buffer.pointer += 2,                                              \
-      parser->mark.index ++,                                                    \
-      parser->mark.column = 0,                                                  \
+      parser->unread --,                                                        \
       parser->mark.line ++,                                                     \
-      parser->unread --) :                                                      \
+      parser->line_start = INDEX(parser)) :                                     \
      (CHECK_AT(parser->buffer,'\xE2',0) &&                                      \
       CHECK_AT(parser->buffer,'\x80',1) &&                                      \
       (CHECK_AT(parser->buffer,'\xA8',2) ||                                     \
@@ -560,12 +584,31 @@
      (*((string).pointer++) = *(parser->buffer.pointer++),                      \
       *((string).pointer++) = *(parser->buffer.pointer++),                      \
       *((string).pointer++) = *(parser->buffer.pointer++),                      \
-      parser->mark.index ++,                                                    \
-      parser->mark.column = 0,                                                  \
+      parser->unread --,                                                        \
       parser->mark.line ++,                                                     \
-      parser->unread --) : 0),                                                  \
+      parser->line_start = INDEX(parser)) : 0),                                 \
     1) : 0)
 
+/*
+ * Take a scratch string of the parser for scanning a scalar, and give it back
+ * with its buffer when the scalar is scanned.
+ */
+
+#define SCRATCH_TAKE(parser,string,scratch)                                     \
+    ((parser)->scratch.start ?                                                  \
+     ((string).start = (parser)->scratch.start,                                 \
+      (string).end = (parser)->scratch.end,                                     \
+      CLEAR(parser,string),                                                     \
+      1) :                                                                      \
+     STRING_INIT(parser,string,INITIAL_STRING_SIZE))
+
+#define SCRATCH_GIVE(parser,string,scratch)                                     \
+    ((string).start ?                                                           \
+     ((parser)->scratch.start = (string).start,                                 \
+      (parser)->scratch.end = (string).end,                                     \
+      (parser)->scratch.pointer = (string).start,                               \
+      (string).start = (string).pointer = (string).end = 0) : 0)
+
 /*
  * Public API declarations.
  */
@@ -591,6 +634,19 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser);
 static int
 yaml_parser_fetch_next_token(yaml_parser_t *parser);
 
+static int
+yaml_parser_fetch_pushed_token(yaml_parser_t *parser);
+
+static int
+yaml_parser_reserve_tokens(yaml_parser_t *parser, size_t count);
+
+static int
+yaml_parser_insert_token(yaml_parser_t *parser, size_t number,
+        yaml_token_t *token);
+
+static int
+yaml_parser_put_pending_tokens(yaml_parser_t *parser);
+
 /*
  * Potential simple keys.
  */
@@ -673,6 +729,25 @@ yaml_parser_fetch_flow_scalar(yaml_parser_t *parser, int single);
 static int
 yaml_parser_fetch_plain_scalar(yaml_parser_t *parser);
 
+static int
+yaml_parser_fetch_json_tokens(yaml_parser_t *parser);
+
+static int
+yaml_parser_fetch_json_string(yaml_parser_t *parser);
+
+static int
+yaml_parser_fetch_json_literal(yaml_parser_t *parser);
+
+static int
+yaml_parser_json_string_length(yaml_parser_t *parser, size_t *length);
+
+static int
+yaml_parser_json_literal_length(yaml_parser_t *parser, size_t *length);
+
+static int
+yaml_parser_scan_json_scalar(yaml_parser_t *parser, yaml_token_t *token,
+        size_t offset, size_t length, yaml_scalar_style_t style);
+
 /*
  * Token scanners.
  */
@@ -680,6 +755,9 @@ yaml_parser_fetch_plain_scalar(yaml_parser_t *parser);
 static int
 yaml_parser_scan_to_next_token(yaml_parser_t *parser);
 
+static size_t
+yaml_parser_line_span(const yaml_char_t *pointer, size_t length);
+
 static int
 yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token);
 
@@ -734,6 +812,23 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
 static int
 yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token);
 
+static size_t
+yaml_parser_quoted_span(const yaml_char_t *pointer, size_t length);
+
+static size_t
+yaml_parser_plain_span(const yaml_char_t *pointer, size_t length, int flow);
+
+static int
+yaml_parser_read_ascii(yaml_parser_t *parser, yaml_string_t *string,
+        size_t length);
+
+static int
+yaml_parser_copy_borrowed(yaml_parser_t *parser, yaml_string_t *string,
+        yaml_char_t **borrowed, size_t length);
+
+static yaml_char_t *
+yaml_parser_copy_scalar(yaml_parser_t *parser, yaml_string_t *string);
+
 /*
  * Get the next token.
  */
@@ -748,6 +843,12 @@ yaml_parser_scan(yaml_parser_t *parser, yaml_token_t *token)
 
     memset(token, 0, sizeof(yaml_token_t));
 
+    /* Release the strings of the previous tokens. */
+
+    if (parser->arena) {
+        yaml_parser_release_arena(parser);
+    }
+
     /* No tokens after STREAM-END or error. */
 
     if (parser->stream_end_produced || parser->error) {
@@ -757,14 +858,16 @@ yaml_parser_scan(yaml_parser_t *parser, yaml_token_t *token)
     /* Ensure that the tokens queue contains enough tokens. */
 
     if (!parser->token_available) {
+        if (parser->read_handler == yaml_feed_read_handler)
+            yaml_parser_compact_tokens(parser);
         if (!yaml_parser_fetch_more_tokens(parser))
-            return 0;
+            return parser->error ? 0 : YAML_PARSER_NEED_MORE_INPUT;
     }
 
     /* Fetch the next token from the queue. */
 
     *token = DEQUEUE(parser, parser->tokens);
-    parser->token_available = 0;
+    parser->token_available --;
     parser->tokens_parsed ++;
 
     if (token->type == YAML_STREAM_END_TOKEN) {
@@ -786,7 +889,7 @@ yaml_parser_set_scanner_error(yaml_parser_t *parser, const char *context,
     parser->context = context;
     parser->context_mark = context_mark;
     parser->problem = problem;
-    parser->problem_mark = parser->mark;
+    parser->problem_mark = MARK(parser);
 
     return 0;
 }
@@ -800,6 +903,8 @@ YAML_DECLARE(int)
 yaml_parser_fetch_more_tokens(yaml_parser_t *parser)
 {
     int need_more_tokens;
+    yaml_simple_key_t *simple_key;
+    size_t available;
 
     /* While we need more tokens to fetch, do it. */
 
@@ -817,22 +922,30 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser)
 
             need_more_tokens = 1;
         }
-        else
+        else if (parser->read_handler == yaml_feed_read_handler
+                && parser->input.feed.checkpoint)
         {
-            yaml_simple_key_t *simple_key;
+            /* The last fetch of a pushed input is not finished. */
 
+            need_more_tokens = 1;
+        }
+        else
+        {
             /* Check if any potential simple key may occupy the head position. */
 
             if (!yaml_parser_stale_simple_keys(parser))
                 return 0;
 
-            for (simple_key = parser->simple_keys.start;
-                    simple_key != parser->simple_keys.top; simple_key++) {
-                if (simple_key->possible
-                        && simple_key->token_number == parser->tokens_parsed) {
-                    need_more_tokens = 1;
-                    break;
-                }
+            /*
+             * The possible keys are saved in the order of their tokens, so
+             * only the lowest one may occupy the head position.
+             */
+
+            simple_key = parser->simple_keys.start + parser->simple_keys_lowest;
+
+            if (simple_key != parser->simple_keys.top
+                    && simple_key->token_number == parser->tokens_parsed) {
+                need_more_tokens = 1;
             }
         }
 
@@ -843,15 +956,247 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser)
 
         /* Fetch the next token. */
 
-        if (!yaml_parser_fetch_next_token(parser))
+        if (parser->read_handler == yaml_feed_read_handler) {
+            if (!yaml_parser_fetch_pushed_token(parser))
+                return 0;
+        }
+        else {
+            if (!yaml_parser_fetch_next_token(parser))
+                return 0;
+        }
+    }
+
+    /* Put the pending tokens that precede the head token in front of it. */
+
+    if (!yaml_parser_put_pending_tokens(parser))
+        return 0;
+
+    /* Bring the mark of the current position up to date for the caller. */
+
+    (void)MARK(parser);
+
+    /*
+     * A pushed input is returned to token by token.  Otherwise, fetch ahead
+     * in a JSON text, and let the caller dequeue the tokens that precede the
+     * lowest potential simple key and the next pending token without calling
+     * us again: nothing can be inserted before them.
+     */
+
+    if (parser->read_handler == yaml_feed_read_handler) {
+        parser->token_available = 1;
+        return 1;
+    }
+
+    if (JSON_MODE(parser) && !yaml_parser_fetch_json_tokens(parser))
+        return 0;
+
+    available = parser->tokens.tail - parser->tokens.head;
+
+    for (simple_key = parser->simple_keys.start + parser->simple_keys_lowest;
+            simple_key != parser->simple_keys.top; simple_key ++) {
+        if (simple_key->possible) {
+            if (available > simple_key->token_number - parser->tokens_parsed)
+                available = simple_key->token_number - parser->tokens_parsed;
+            break;
+        }
+    }
+
+    if (parser->pending_tokens.head != parser->pending_tokens.tail
+            && available > parser->pending_tokens.head->token_number
+                - parser->tokens_parsed) {
+        available = parser->pending_tokens.head->token_number
+            - parser->tokens_parsed;
+    }
+
+    parser->token_available = available;
+
+    return 1;
+}
+
+/*
+ * Move the unparsed tokens to the beginning of the queue.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_compact_tokens(yaml_parser_t *parser)
+{
+    size_t count = parser->tokens.tail - parser->tokens.head;
+
+    if (parser->tokens.head == parser->tokens.start)
+        return;
+
+    memmove(parser->tokens.start, parser->tokens.head,
+            count*sizeof(*parser->tokens.start));
+    parser->tokens.head = parser->tokens.start;
+    parser->tokens.tail = parser->tokens.start + count;
+}
+
+/*
+ * Ensure that the tokens queue has room for the given number of tokens after
+ * the tail.  The queue is grown rather than moved.
+ */
+
+static int
+yaml_parser_reserve_tokens(yaml_parser_t *parser, size_t count)
+{
+    size_t size = parser->tokens.end - parser->tokens.start;
+    yaml_token_t *start;
+
+    if ((size_t)(parser->tokens.end - parser->tokens.tail) >= count)
+        return 1;
+
+    while (size - (parser->tokens.tail - parser->tokens.start) < count)
+        size *= 2;
+
+    start = yaml_realloc(parser->tokens.start, size*sizeof(*start));
+    if (!start) {
+        parser->error = YAML_MEMORY_ERROR;
+        return 0;
+    }
+
+    parser->tokens.head = start + (parser->tokens.head - parser->tokens.start);
+    parser->tokens.tail = start + (parser->tokens.tail - parser->tokens.start);
+    parser->tokens.end = start + size;
+    parser->tokens.start = start;
+
+    return 1;
+}
+
+/*
+ * Insert a token before the queued token with the given number.
+ *
+ * Rather than shifting the tokens that follow it, the token is kept in the
+ * pending tokens queue until the head of the tokens queue reaches it.  The
+ * numbers of the pending tokens are kept as if they were already in the
+ * tokens queue, so the numbers of the following pending tokens are shifted.
+ */
+
+static int
+yaml_parser_insert_token(yaml_parser_t *parser, size_t number,
+        yaml_token_t *token)
+{
+    yaml_pending_token_t pending;
+    yaml_pending_token_t *following = parser->pending_tokens.tail;
+    size_t index;
+
+    while (following != parser->pending_tokens.head
+            && (following-1)->token_number >= number) {
+        following --;
+        following->token_number ++;
+    }
+
+    index = following - parser->pending_tokens.head;
+    pending.token_number = number;
+    pending.token = *token;
+
+    return QUEUE_INSERT(parser, parser->pending_tokens, index, pending);
+}
+
+/*
+ * Move the pending tokens that precede the head token to the tokens queue.
+ *
+ * The tokens are put in the free room before the head, unless the parser of a
+ * pushed input may return to the tokens skipped there.
+ */
+
+static int
+yaml_parser_put_pending_tokens(yaml_parser_t *parser)
+{
+    yaml_pending_token_t *pending = parser->pending_tokens.head;
+    size_t count = 0;
+
+    while (pending + count != parser->pending_tokens.tail
+            && pending[count].token_number == parser->tokens_parsed + count)
+        count ++;
+
+    if (!count)
+        return 1;
+
+    if ((size_t)(parser->tokens.head - parser->tokens.start) < count
+            || parser->read_handler == yaml_feed_read_handler)
+    {
+        if (!yaml_parser_reserve_tokens(parser, count))
             return 0;
+
+        memmove(parser->tokens.head + count, parser->tokens.head,
+                (parser->tokens.tail - parser->tokens.head)
+                * sizeof(*parser->tokens.start));
+        parser->tokens.head += count;
+        parser->tokens.tail += count;
     }
 
-    parser->token_available = 1;
+    parser->pending_tokens.head += count;
+
+    while (count --) {
+        *(--parser->tokens.head) = pending[count].token;
+    }
 
     return 1;
 }
 
+/*
+ * Fetch the next token from a pushed input.
+ *
+ * If the input runs out in the middle of the token, the scanner returns to
+ * where the token started, and the fetch is repeated when more input is fed.
+ * The fetchers change nothing but the position, the simple_key_allowed flag,
+ * and the innermost simple key before they are done reading; the changes of
+ * the other state (the indentation, the stale simple keys) are repeated with
+ * the same result.  The checkpoint stays set until the fetch is finished, so
+ * that the tokens it has already queued are not taken for a complete fetch.
+ *
+ * The token queue is grown rather than moved, so that the parser may return
+ * to the tokens skipped since the beginning of the current event.
+ */
+
+static int
+yaml_parser_fetch_pushed_token(yaml_parser_t *parser)
+{
+    yaml_mark_t mark = MARK(parser);
+    size_t line_start = parser->line_start;
+    int simple_key_allowed = parser->simple_key_allowed;
+    yaml_simple_key_t simple_key = { 0, 0, 0, { 0, 0, 0 } };
+    int has_simple_key = !STACK_EMPTY(parser, parser->simple_keys);
+    size_t simple_keys_lowest = parser->simple_keys_lowest;
+    size_t count = parser->indents.top - parser->indents.start + 4;
+
+    /*
+     * A fetch adds at most one BLOCK-END per indentation level and three
+     * other tokens.
+     */
+
+    if (!yaml_parser_reserve_tokens(parser, count))
+        return 0;
+
+    if (has_simple_key) {
+        simple_key = *(parser->simple_keys.top-1);
+    }
+
+    parser->input.feed.checkpoint = parser->buffer.pointer;
+
+    if (yaml_parser_fetch_next_token(parser)) {
+        parser->input.feed.checkpoint = NULL;
+        return 1;
+    }
+
+    if (!parser->error) {
+        parser->unread = parser->decoded - mark.index;
+        parser->buffer.pointer = parser->input.feed.checkpoint;
+        parser->mark = mark;
+        parser->line_start = line_start;
+        parser->simple_key_allowed = simple_key_allowed;
+        if (has_simple_key) {
+            *(parser->simple_keys.top-1) = simple_key;
+        }
+        parser->simple_keys_lowest = simple_keys_lowest;
+    }
+    else {
+        parser->input.feed.checkpoint = NULL;
+    }
+
+    return 0;
+}
+
 /*
  * The dispatcher for token fetchers.
  */
@@ -881,7 +1226,7 @@ yaml_parser_fetch_next_token(yaml_parser_t *parser)
 
     /* Check the indentation level against the current column. */
 
-    if (!yaml_parser_unroll_indent(parser, parser->mark.column))
+    if (!yaml_parser_unroll_indent(parser, COLUMN(parser)))
         return 0;
 
     /*
@@ -892,164 +1237,163 @@ yaml_parser_fetch_next_token(yaml_parser_t *parser)
     if (!CACHE(parser, 4))
         return 0;
 
-    /* Is it the end of the stream? */
-
-    if (IS_Z(parser->buffer))
-        return yaml_parser_fetch_stream_end(parser);
-
-    /* Is it a directive? */
-
-    if (parser->mark.column == 0 && CHECK(parser->buffer, '%'))
-        return yaml_parser_fetch_directive(parser);
-
-    /* Is it the document start indicator? */
-
-    if (parser->mark.column == 0
-            && CHECK_AT(parser->buffer, '-', 0)
-            && CHECK_AT(parser->buffer, '-', 1)
-            && CHECK_AT(parser->buffer, '-', 2)
-            && IS_BLANKZ_AT(parser->buffer, 3))
-        return yaml_parser_fetch_document_indicator(parser,
-                YAML_DOCUMENT_START_TOKEN);
-
-    /* Is it the document end indicator? */
-
-    if (parser->mark.column == 0
-            && CHECK_AT(parser->buffer, '.', 0)
-            && CHECK_AT(parser->buffer, '.', 1)
-            && CHECK_AT(parser->buffer, '.', 2)
-            && IS_BLANKZ_AT(parser->buffer, 3))
-        return yaml_parser_fetch_document_indicator(parser,
-                YAML_DOCUMENT_END_TOKEN);
-
-    /* Is it the flow sequence start indicator? */
-
-    if (CHECK(parser->buffer, '['))
-        return yaml_parser_fetch_flow_collection_start(parser,
-                YAML_FLOW_SEQUENCE_START_TOKEN);
-
-    /* Is it the flow mapping start indicator? */
-
-    if (CHECK(parser->buffer, '{'))
-        return yaml_parser_fetch_flow_collection_start(parser,
-                YAML_FLOW_MAPPING_START_TOKEN);
-
-    /* Is it the flow sequence end indicator? */
-
-    if (CHECK(parser->buffer, ']'))
-        return yaml_parser_fetch_flow_collection_end(parser,
-                YAML_FLOW_SEQUENCE_END_TOKEN);
-
-    /* Is it the flow mapping end indicator? */
-
-    if (CHECK(parser->buffer, '}'))
-        return yaml_parser_fetch_flow_collection_end(parser,
-                YAML_FLOW_MAPPING_END_TOKEN);
+    /*
+     * Dispatch on the first character, so that a token is found with a
+     * single jump rather than by probing every indicator in turn.
+     */
 
-    /* Is it the flow entry indicator? */
+    switch (parser->buffer.pointer[0])
+    {
+        /* Is it the end of the stream? */
 
-    if (CHECK(parser->buffer, ','))
-        return yaml_parser_fetch_flow_entry(parser);
+        case '\0':
+            return yaml_parser_fetch_stream_end(parser);
 
-    /* Is it the block entry indicator? */
+        /* Is it a directive? */
 
-    if (CHECK(parser->buffer, '-') && IS_BLANKZ_AT(parser->buffer, 1))
-        return yaml_parser_fetch_block_entry(parser);
+        case '%':
+            if (COLUMN(parser) == 0)
+                return yaml_parser_fetch_directive(parser);
+            break;
 
-    /* Is it the key indicator? */
+        /*
+         * Is it the document start indicator, the block entry indicator or a
+         * plain scalar?
+         */
 
-    if (CHECK(parser->buffer, '?')
-            && (parser->flow_level || IS_BLANKZ_AT(parser->buffer, 1)))
-        return yaml_parser_fetch_key(parser);
+        case '-':
+            if (COLUMN(parser) == 0
+                    && CHECK_AT(parser->buffer, '-', 1)
+                    && CHECK_AT(parser->buffer, '-', 2)
+                    && IS_BLANKZ_AT(parser->buffer, 3))
+                return yaml_parser_fetch_document_indicator(parser,
+                        YAML_DOCUMENT_START_TOKEN);
+            if (IS_BLANKZ_AT(parser->buffer, 1))
+                return yaml_parser_fetch_block_entry(parser);
+            if (JSON_MODE(parser))
+                return yaml_parser_fetch_json_literal(parser);
+            return yaml_parser_fetch_plain_scalar(parser);
+
+        /* Is it the document end indicator or a plain scalar? */
+
+        case '.':
+            if (COLUMN(parser) == 0
+                    && CHECK_AT(parser->buffer, '.', 1)
+                    && CHECK_AT(parser->buffer, '.', 2)
+                    && IS_BLANKZ_AT(parser->buffer, 3))
+                return yaml_parser_fetch_document_indicator(parser,
+                        YAML_DOCUMENT_END_TOKEN);
+            return yaml_parser_fetch_plain_scalar(parser);
+
+        /* Is it a flow collection indicator? */
+
+        case '[':
+            return yaml_parser_fetch_flow_collection_start(parser,
+                    YAML_FLOW_SEQUENCE_START_TOKEN);
+
+        case '{':
+            return yaml_parser_fetch_flow_collection_start(parser,
+                    YAML_FLOW_MAPPING_START_TOKEN);
+
+        case ']':
+            return yaml_parser_fetch_flow_collection_end(parser,
+                    YAML_FLOW_SEQUENCE_END_TOKEN);
+
+        case '}':
+            return yaml_parser_fetch_flow_collection_end(parser,
+                    YAML_FLOW_MAPPING_END_TOKEN);
+
+        /* Is it the flow entry indicator? */
+
+        case ',':
+            return yaml_parser_fetch_flow_entry(parser);
 
-    /* Is it the value indicator? */
+        /*
+         * Is it the key or the value indicator?  In the block context, they
+         * may also start a plain scalar if followed by a non-space character.
+         */
 
-    if (CHECK(parser->buffer, ':')
-            && (parser->flow_level || IS_BLANKZ_AT(parser->buffer, 1)))
-        return yaml_parser_fetch_value(parser);
+        case '?':
+            if (parser->flow_level || IS_BLANKZ_AT(parser->buffer, 1))
+                return yaml_parser_fetch_key(parser);
+            return yaml_parser_fetch_plain_scalar(parser);
 
-    /* Is it an alias? */
+        case ':':
+            if (parser->flow_level || IS_BLANKZ_AT(parser->buffer, 1))
+                return yaml_parser_fetch_value(parser);
+            return yaml_parser_fetch_plain_scalar(parser);
 
-    if (CHECK(parser->buffer, '*'))
-        return yaml_parser_fetch_anchor(parser, YAML_ALIAS_TOKEN);
+        /* Is it an alias or an anchor? */
 
-    /* Is it an anchor? */
+        case '*':
+            return yaml_parser_fetch_anchor(parser, YAML_ALIAS_TOKEN);
 
-    if (CHECK(parser->buffer, '&'))
-        return yaml_parser_fetch_anchor(parser, YAML_ANCHOR_TOKEN);
+        case '&':
+            return yaml_parser_fetch_anchor(parser, YAML_ANCHOR_TOKEN);
 
-    /* Is it a tag? */
+        /* Is it a tag? */
 
-    if (CHECK(parser->buffer, '!'))
-        return yaml_parser_fetch_tag(parser);
+        case '!':
+            return yaml_parser_fetch_tag(parser);
 
-    /* Is it a literal scalar? */
+        /* Is it a literal or a folded scalar? */
 
-    if (CHECK(parser->buffer, '|') && !parser->flow_level)
-        return yaml_parser_fetch_block_scalar(parser, 1);
+        case '|':
+            if (!parser->flow_level)
+                return yaml_parser_fetch_block_scalar(parser, 1);
+            break;
 
-    /* Is it a folded scalar? */
+        case '>':
+            if (!parser->flow_level)
+                return yaml_parser_fetch_block_scalar(parser, 0);
+            break;
 
-    if (CHECK(parser->buffer, '>') && !parser->flow_level)
-        return yaml_parser_fetch_block_scalar(parser, 0);
+        /* Is it a single-quoted or a double-quoted scalar? */
 
-    /* Is it a single-quoted scalar? */
+        case '\'':
+            return yaml_parser_fetch_flow_scalar(parser, 1);
 
-    if (CHECK(parser->buffer, '\''))
-        return yaml_parser_fetch_flow_scalar(parser, 1);
+        case '"':
+            if (JSON_MODE(parser))
+                return yaml_parser_fetch_json_string(parser);
+            return yaml_parser_fetch_flow_scalar(parser, 0);
 
-    /* Is it a double-quoted scalar? */
+        /* These characters are reserved and cannot start a plain scalar. */
 
-    if (CHECK(parser->buffer, '"'))
-        return yaml_parser_fetch_flow_scalar(parser, 0);
+        case '#':
+        case '@':
+        case '`':
+            break;
 
-    /*
-     * Is it a plain scalar?
-     *
-     * A plain scalar may start with any non-blank characters except
-     *
-     *      '-', '?', ':', ',', '[', ']', '{', '}',
-     *      '#', '&', '*', '!', '|', '>', '\'', '\"',
-     *      '%', '@', '`'.
-     *
-     * In the block context (and, for the '-' indicator, in the flow context
-     * too), it may also start with the characters
-     *
-     *      '-', '?', ':'
-     *
-     * if it is followed by a non-space character.
-     *
-     * The last rule is more restrictive than the specification requires.
-     */
+        /*
+         * Is it a plain scalar?  It may start with any other non-blank
+         * character.
+         */
 
-    if (!(IS_BLANKZ(parser->buffer) || CHECK(parser->buffer, '-')
-                || CHECK(parser->buffer, '?') || CHECK(parser->buffer, ':')
-                || CHECK(parser->buffer, ',') || CHECK(parser->buffer, '[')
-                || CHECK(parser->buffer, ']') || CHECK(parser->buffer, '{')
-                || CHECK(parser->buffer, '}') || CHECK(parser->buffer, '#')
-                || CHECK(parser->buffer, '&') || CHECK(parser->buffer, '*')
-                || CHECK(parser->buffer, '!') || CHECK(parser->buffer, '|')
-                || CHECK(parser->buffer, '>') || CHECK(parser->buffer, '\'')
-                || CHECK(parser->buffer, '"') || CHECK(parser->buffer, '%')
-                || CHECK(parser->buffer, '@') || CHECK(parser->buffer, '`')) ||
-            (CHECK(parser->buffer, '-') && !IS_BLANK_AT(parser->buffer, 1)) ||
-            (!parser->flow_level &&
-             (CHECK(parser->buffer, '?') || CHECK(parser->buffer, ':'))
-             && !IS_BLANKZ_AT(parser->buffer, 1)))
-        return yaml_parser_fetch_plain_scalar(parser);
+        default:
+            if (IS_BLANKZ(parser->buffer))
+                break;
+            if (JSON_MODE(parser))
+                return yaml_parser_fetch_json_literal(parser);
+            return yaml_parser_fetch_plain_scalar(parser);
+    }
 
     /*
      * If we don't determine the token type so far, it is an error.
      */
 
     return yaml_parser_set_scanner_error(parser,
-            "while scanning for the next token", parser->mark,
+            "while scanning for the next token", MARK(parser),
             "found character that cannot start any token");
 }
 
 /*
  * Check the list of potential simple keys and remove the positions that
  * cannot contain simple keys anymore.
+ *
+ * A key is only saved at the innermost flow level, so the possible keys are
+ * ordered by their positions from the lowest level up.  The stale keys come
+ * first, and the check stops at the first key that is still possible.
  */
 
 static int
@@ -1059,7 +1403,7 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
 
     /* Check for a potential simple key for each flow level. */
 
-    for (simple_key = parser->simple_keys.start;
+    for (simple_key = parser->simple_keys.start + parser->simple_keys_lowest;
             simple_key != parser->simple_keys.top; simple_key ++)
     {
         /*
@@ -1071,7 +1415,7 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
 
         if (simple_key->possible
                 && (simple_key->mark.line < parser->mark.line
-                    || simple_key->mark.index+1024 < parser->mark.index)) {
+                    || simple_key->mark.index+1024 < INDEX(parser))) {
 
             /* Check if the potential simple key to be removed is required. */
 
@@ -1083,8 +1427,15 @@ yaml_parser_stale_simple_keys(yaml_parser_t *parser)
 
             simple_key->possible = 0;
         }
+
+        /* The keys above are more recent, so they are not stale either. */
+
+        else if (simple_key->possible)
+            break;
     }
 
+    parser->simple_keys_lowest = simple_key - parser->simple_keys.start;
+
     return 1;
 }
 
@@ -1103,7 +1454,7 @@ yaml_parser_save_simple_key(yaml_parser_t *parser)
      */
 
     int required = (!parser->flow_level
-            && parser->indent == (ptrdiff_t)parser->mark.column);
+            && parser->indent == (ptrdiff_t)COLUMN(parser));
 
     /*
      * If the current position may start a simple key, save it.
@@ -1114,13 +1465,20 @@ yaml_parser_save_simple_key(yaml_parser_t *parser)
         yaml_simple_key_t simple_key;
         simple_key.possible = 1;
         simple_key.required = required;
-        simple_key.token_number =
-            parser->tokens_parsed + (parser->tokens.tail - parser->tokens.head);
-        simple_key.mark = parser->mark;
+        simple_key.token_number = parser->tokens_parsed
+            + (parser->tokens.tail - parser->tokens.head)
+            + (parser->pending_tokens.tail - parser->pending_tokens.head);
+        simple_key.mark = MARK(parser);
 
         if (!yaml_parser_remove_simple_key(parser)) return 0;
 
         *(parser->simple_keys.top-1) = simple_key;
+
+        if (parser->simple_keys_lowest
+                > (size_t)(parser->simple_keys.top - parser->simple_keys.start - 1)) {
+            parser->simple_keys_lowest =
+                parser->simple_keys.top - parser->simple_keys.start - 1;
+        }
     }
 
     return 1;
@@ -1189,6 +1547,11 @@ yaml_parser_decrease_flow_level(yaml_parser_t *parser)
     if (parser->flow_level) {
         parser->flow_level --;
         (void)POP(parser, parser->simple_keys);
+        if (parser->simple_keys_lowest
+                > (size_t)(parser->simple_keys.top - parser->simple_keys.start)) {
+            parser->simple_keys_lowest =
+                parser->simple_keys.top - parser->simple_keys.start;
+        }
     }
 
     return 1;
@@ -1238,8 +1601,7 @@ yaml_parser_roll_indent(yaml_parser_t *parser, ptrdiff_t column,
                 return 0;
         }
         else {
-            if (!QUEUE_INSERT(parser,
-                        parser->tokens, number - parser->tokens_parsed, token))
+            if (!yaml_parser_insert_token(parser, number, &token))
                 return 0;
         }
     }
@@ -1270,7 +1632,7 @@ yaml_parser_unroll_indent(yaml_parser_t *parser, ptrdiff_t column)
     {
         /* Create a token and append it to the queue. */
 
-        TOKEN_INIT(token, YAML_BLOCK_END_TOKEN, parser->mark, parser->mark);
+        TOKEN_INIT(token, YAML_BLOCK_END_TOKEN, MARK(parser), MARK(parser));
 
         if (!ENQUEUE(parser, parser->tokens, token))
             return 0;
@@ -1313,7 +1675,7 @@ yaml_parser_fetch_stream_start(yaml_parser_t *parser)
     /* Create the STREAM-START token and append it to the queue. */
 
     STREAM_START_TOKEN_INIT(token, parser->encoding,
-            parser->mark, parser->mark);
+            MARK(parser), MARK(parser));
 
     if (!ENQUEUE(parser, parser->tokens, token))
         return 0;
@@ -1332,8 +1694,8 @@ yaml_parser_fetch_stream_end(yaml_parser_t *parser)
 
     /* Force new line. */
 
-    if (parser->mark.column != 0) {
-        parser->mark.column = 0;
+    if (COLUMN(parser) != 0) {
+        parser->line_start = INDEX(parser);
         parser->mark.line ++;
     }
 
@@ -1351,7 +1713,7 @@ yaml_parser_fetch_stream_end(yaml_parser_t *parser)
 
     /* Create the STREAM-END token and append it to the queue. */
 
-    STREAM_END_TOKEN_INIT(token, parser->mark, parser->mark);
+    STREAM_END_TOKEN_INIT(token, MARK(parser), MARK(parser));
 
     if (!ENQUEUE(parser, parser->tokens, token))
         return 0;
@@ -1420,13 +1782,13 @@ yaml_parser_fetch_document_indicator(yaml_parser_t *parser,
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     SKIP(parser);
     SKIP(parser);
     SKIP(parser);
 
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the DOCUMENT-START or DOCUMENT-END token. */
 
@@ -1456,6 +1818,12 @@ yaml_parser_fetch_flow_collection_start(yaml_parser_t *parser,
     if (!yaml_parser_save_simple_key(parser))
         return 0;
 
+    /* Is it the root node of a document, like a JSON text? */
+
+    if (!parser->flow_level) {
+        parser->json_root = (parser->indent == -1);
+    }
+
     /* Increase the flow level. */
 
     if (!yaml_parser_increase_flow_level(parser))
@@ -1467,9 +1835,9 @@ yaml_parser_fetch_flow_collection_start(yaml_parser_t *parser,
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the FLOW-SEQUENCE-START of FLOW-MAPPING-START token. */
 
@@ -1510,9 +1878,9 @@ yaml_parser_fetch_flow_collection_end(yaml_parser_t *parser,
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the FLOW-SEQUENCE-END of FLOW-MAPPING-END token. */
 
@@ -1547,9 +1915,9 @@ yaml_parser_fetch_flow_entry(yaml_parser_t *parser)
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the FLOW-ENTRY token and append it to the queue. */
 
@@ -1578,14 +1946,14 @@ yaml_parser_fetch_block_entry(yaml_parser_t *parser)
         /* Check if we are allowed to start a new entry. */
 
         if (!parser->simple_key_allowed) {
-            return yaml_parser_set_scanner_error(parser, NULL, parser->mark,
+            return yaml_parser_set_scanner_error(parser, NULL, MARK(parser),
                     "block sequence entries are not allowed in this context");
         }
 
         /* Add the BLOCK-SEQUENCE-START token if needed. */
 
-        if (!yaml_parser_roll_indent(parser, parser->mark.column, -1,
-                    YAML_BLOCK_SEQUENCE_START_TOKEN, parser->mark))
+        if (!yaml_parser_roll_indent(parser, COLUMN(parser), -1,
+                    YAML_BLOCK_SEQUENCE_START_TOKEN, MARK(parser)))
             return 0;
     }
     else
@@ -1608,9 +1976,9 @@ yaml_parser_fetch_block_entry(yaml_parser_t *parser)
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the BLOCK-ENTRY token and append it to the queue. */
 
@@ -1639,14 +2007,14 @@ yaml_parser_fetch_key(yaml_parser_t *parser)
         /* Check if we are allowed to start a new key (not necessary simple). */
 
         if (!parser->simple_key_allowed) {
-            return yaml_parser_set_scanner_error(parser, NULL, parser->mark,
+            return yaml_parser_set_scanner_error(parser, NULL, MARK(parser),
                     "mapping keys are not allowed in this context");
         }
 
         /* Add the BLOCK-MAPPING-START token if needed. */
 
-        if (!yaml_parser_roll_indent(parser, parser->mark.column, -1,
-                    YAML_BLOCK_MAPPING_START_TOKEN, parser->mark))
+        if (!yaml_parser_roll_indent(parser, COLUMN(parser), -1,
+                    YAML_BLOCK_MAPPING_START_TOKEN, MARK(parser)))
             return 0;
     }
 
@@ -1661,9 +2029,9 @@ yaml_parser_fetch_key(yaml_parser_t *parser)
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the KEY token and append it to the queue. */
 
@@ -1695,8 +2063,8 @@ yaml_parser_fetch_value(yaml_parser_t *parser)
 
         TOKEN_INIT(token, YAML_KEY_TOKEN, simple_key->mark, simple_key->mark);
 
-        if (!QUEUE_INSERT(parser, parser->tokens,
-                    simple_key->token_number - parser->tokens_parsed, token))
+        if (!yaml_parser_insert_token(parser, simple_key->token_number,
+                    &token))
             return 0;
 
         /* In the block context, we may need to add the BLOCK-MAPPING-START token. */
@@ -1725,14 +2093,14 @@ yaml_parser_fetch_value(yaml_parser_t *parser)
             /* Check if we are allowed to start a complex value. */
 
             if (!parser->simple_key_allowed) {
-                return yaml_parser_set_scanner_error(parser, NULL, parser->mark,
+                return yaml_parser_set_scanner_error(parser, NULL, MARK(parser),
                         "mapping values are not allowed in this context");
             }
 
             /* Add the BLOCK-MAPPING-START token if needed. */
 
-            if (!yaml_parser_roll_indent(parser, parser->mark.column, -1,
-                        YAML_BLOCK_MAPPING_START_TOKEN, parser->mark))
+            if (!yaml_parser_roll_indent(parser, COLUMN(parser), -1,
+                        YAML_BLOCK_MAPPING_START_TOKEN, MARK(parser)))
                 return 0;
         }
 
@@ -1743,9 +2111,9 @@ yaml_parser_fetch_value(yaml_parser_t *parser)
 
     /* Consume the token. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
     SKIP(parser);
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create the VALUE token and append it to the queue. */
 
@@ -1863,52 +2231,502 @@ yaml_parser_fetch_flow_scalar(yaml_parser_t *parser, int single)
     if (!yaml_parser_save_simple_key(parser))
         return 0;
 
-    /* A simple key cannot follow a flow scalar. */
+    /* A simple key cannot follow a flow scalar. */
+
+    parser->simple_key_allowed = 0;
+
+    /* Create the SCALAR token and append it to the queue. */
+
+    if (!yaml_parser_scan_flow_scalar(parser, &token, single))
+        return 0;
+
+    if (!ENQUEUE(parser, parser->tokens, token)) {
+        yaml_token_delete(&token);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the SCALAR(...,plain) token.
+ */
+
+static int
+yaml_parser_fetch_plain_scalar(yaml_parser_t *parser)
+{
+    yaml_token_t token;
+
+    /* A plain scalar could be a simple key. */
+
+    if (!yaml_parser_save_simple_key(parser))
+        return 0;
+
+    /* A simple key cannot follow a flow scalar. */
+
+    parser->simple_key_allowed = 0;
+
+    /* Create the SCALAR token and append it to the queue. */
+
+    if (!yaml_parser_scan_plain_scalar(parser, &token))
+        return 0;
+
+    if (!ENQUEUE(parser, parser->tokens, token)) {
+        yaml_token_delete(&token);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Fetch the following tokens of a JSON text from the cached input.
+ *
+ * Only the tokens that cannot fail are fetched here: the flow indicators, the
+ * strings without escapes and the literals.  Anything else, a comment, or the
+ * end of the cached input ends the run, and is left to the dispatcher, so that
+ * an error is reported after the same tokens and input as usual.
+ *
+ * A token is only fetched if the dispatcher would not read the input for it
+ * either: 4 characters are cached at the start of the token, as the dispatcher
+ * ensures before it looks at the token, and 4 after the end of a scalar.  The
+ * run stops when the queue holds JSON_TOKEN_RUN tokens.
+ */
+
+static int
+yaml_parser_fetch_json_tokens(yaml_parser_t *parser)
+{
+    size_t length;
+
+    while (parser->tokens.tail - parser->tokens.head < JSON_TOKEN_RUN
+            && JSON_MODE(parser))
+    {
+        yaml_char_t *pointer = parser->buffer.pointer;
+        size_t unread = parser->unread;
+        size_t line = parser->mark.line;
+        size_t line_start = parser->line_start;
+        int fetchable;
+
+        /* Eat blanks and line breaks. */
+
+        while (parser->unread > 1)
+        {
+            if (CHECK(parser->buffer, ' ') || CHECK(parser->buffer, '\t')) {
+                SKIP_ASCII(parser, 1);
+            }
+            else if (CHECK(parser->buffer, '\n')
+                    || CHECK(parser->buffer, '\r')) {
+                SKIP_LINE(parser);
+            }
+            else {
+                break;
+            }
+        }
+
+        /* Check if the next token may be fetched here. */
+
+        if (parser->unread < 4) {
+            fetchable = 0;
+        }
+        else if (CHECK(parser->buffer, '"')) {
+            fetchable = yaml_parser_json_string_length(parser, &length);
+        }
+        else if (IS_ALPHA(parser->buffer)) {
+            fetchable = yaml_parser_json_literal_length(parser, &length);
+        }
+        else {
+            fetchable = (CHECK(parser->buffer, '[')
+                    || CHECK(parser->buffer, '{')
+                    || CHECK(parser->buffer, ']')
+                    || CHECK(parser->buffer, '}')
+                    || CHECK(parser->buffer, ',')
+                    || CHECK(parser->buffer, ':'));
+        }
+
+        /*
+         * Otherwise, leave the blanks to the dispatcher as well: a line break
+         * eaten here would make the simple keys stale before the dispatcher
+         * gets a chance to fail, and let the held back tokens go early.
+         */
+
+        if (!fetchable) {
+            parser->buffer.pointer = pointer;
+            parser->unread = unread;
+            parser->mark.line = line;
+            parser->line_start = line_start;
+            break;
+        }
+
+        /* Remove obsolete potential simple keys. */
+
+        if (!yaml_parser_stale_simple_keys(parser))
+            return 0;
+
+        /* Fetch the token. */
+
+        switch (parser->buffer.pointer[0])
+        {
+            case '[':
+                if (!yaml_parser_fetch_flow_collection_start(parser,
+                            YAML_FLOW_SEQUENCE_START_TOKEN))
+                    return 0;
+                break;
+
+            case '{':
+                if (!yaml_parser_fetch_flow_collection_start(parser,
+                            YAML_FLOW_MAPPING_START_TOKEN))
+                    return 0;
+                break;
+
+            case ']':
+                if (!yaml_parser_fetch_flow_collection_end(parser,
+                            YAML_FLOW_SEQUENCE_END_TOKEN))
+                    return 0;
+                break;
+
+            case '}':
+                if (!yaml_parser_fetch_flow_collection_end(parser,
+                            YAML_FLOW_MAPPING_END_TOKEN))
+                    return 0;
+                break;
+
+            case ',':
+                if (!yaml_parser_fetch_flow_entry(parser))
+                    return 0;
+                break;
+
+            case ':':
+                if (!yaml_parser_fetch_value(parser))
+                    return 0;
+                break;
+
+            case '"':
+                if (!yaml_parser_fetch_json_string(parser))
+                    return 0;
+                break;
+
+            default:
+                if (!yaml_parser_fetch_json_literal(parser))
+                    return 0;
+                break;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the SCALAR(...,double-quoted) token of a JSON string, preceded by
+ * the KEY token and followed by the VALUE token if the string is a key.
+ *
+ * The string is saved as a potential simple key as usual.  If a ':' follows
+ * the string on the same line, the VALUE token is fetched at once, so the KEY
+ * token is queued in order rather than inserted.  Otherwise, the key is only
+ * settled by the next token, and the head token is held back until then, so
+ * an error that follows the string is reported before the string, exactly as
+ * without the tokenizer.
+ */
+
+static int
+yaml_parser_fetch_json_string(yaml_parser_t *parser)
+{
+    yaml_simple_key_t *simple_key = parser->simple_keys.top-1;
+    int simple_key_allowed = parser->simple_key_allowed;
+    yaml_token_t token;
+    size_t length;
+
+    /* A double-quoted scalar could be a simple key. */
+
+    if (!yaml_parser_save_simple_key(parser))
+        return 0;
+
+    /* A simple key cannot follow a flow scalar. */
+
+    parser->simple_key_allowed = 0;
+
+    /* Create the SCALAR token, at once if the string has no escapes. */
+
+    if (yaml_parser_json_string_length(parser, &length)) {
+        if (!yaml_parser_scan_json_scalar(parser, &token, 1, length,
+                    YAML_DOUBLE_QUOTED_SCALAR_STYLE))
+            return 0;
+    }
+    else {
+        if (!yaml_parser_scan_flow_scalar(parser, &token, 0))
+            return 0;
+    }
+
+    /*
+     * Fetch the ':' together with the string if the dispatcher would not read
+     * the input for it either.
+     */
+
+    if (simple_key_allowed)
+    {
+        const yaml_char_t *pointer = parser->buffer.pointer;
+        size_t k = 0;
+
+        while (k < parser->unread && (pointer[k] == ' ' || pointer[k] == '\t'))
+            k ++;
+
+        if (k+4 <= parser->unread && pointer[k] == ':')
+        {
+            if (simple_key->mark.line == parser->mark.line
+                    && simple_key->mark.index+1024 >= INDEX(parser)+k)
+            {
+                yaml_token_t key_token;
+
+                TOKEN_INIT(key_token, YAML_KEY_TOKEN,
+                        simple_key->mark, simple_key->mark);
+
+                if (!ENQUEUE(parser, parser->tokens, key_token)) {
+                    yaml_token_delete(&token);
+                    return 0;
+                }
+            }
+
+            simple_key->possible = 0;
+
+            if (!ENQUEUE(parser, parser->tokens, token)) {
+                yaml_token_delete(&token);
+                return 0;
+            }
+
+            SKIP_ASCII(parser, k);
+
+            return yaml_parser_fetch_value(parser);
+        }
+    }
+
+    /* Append the SCALAR token to the queue. */
+
+    if (!ENQUEUE(parser, parser->tokens, token)) {
+        yaml_token_delete(&token);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Produce the SCALAR(...,plain) token of a JSON number, true, false or null.
+ *
+ * The indicator that ends the literal removes any simple key on the current
+ * flow level, so the literal is not saved as one.  Other plain scalars are
+ * scanned as usual.
+ */
+
+static int
+yaml_parser_fetch_json_literal(yaml_parser_t *parser)
+{
+    yaml_token_t token;
+    size_t length;
+
+    if (!yaml_parser_json_literal_length(parser, &length))
+        return yaml_parser_fetch_plain_scalar(parser);
+
+    /* A simple key cannot follow a flow scalar. */
+
+    parser->simple_key_allowed = 0;
+
+    /* Create the SCALAR token and append it to the queue. */
+
+    if (!yaml_parser_scan_json_scalar(parser, &token, 0, length,
+                YAML_PLAIN_SCALAR_STYLE))
+        return 0;
+
+    if (!ENQUEUE(parser, parser->tokens, token)) {
+        yaml_token_delete(&token);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Check if a double-quoted scalar consists of ASCII characters without
+ * escapes and line breaks up to the closing quote in the cached input, and
+ * return the length of its value.
+ *
+ * The scalar scanner caches 4 characters at every run of blanks and 2 at the
+ * closing quote, so the scalar is only taken if the 4 characters after the
+ * closing quote are cached as well.  The scanner would not read the input for
+ * it then, and would not report a reader error at a different token.
+ */
+
+static int
+yaml_parser_json_string_length(yaml_parser_t *parser, size_t *length)
+{
+    const yaml_char_t *pointer = parser->buffer.pointer+1;
+    size_t unread = parser->unread-1;
+    size_t k = 0;
+
+    while (1) {
+        k += yaml_parser_quoted_span(pointer+k, unread-k);
+        if (k < unread && (pointer[k] == ' ' || pointer[k] == '\t'
+                    || pointer[k] == '\''))
+            k ++;
+        else
+            break;
+    }
+
+    *length = k;
+
+    return (k+4 < unread && pointer[k] == '"');
+}
+
+/*
+ * Check if a plain scalar consists of a run of ordinary characters that ends
+ * at one of ',]}' in the cached input, as a JSON number, true, false or null
+ * does, and return its length.
+ *
+ * As with a string, the scalar is only taken if the 4 characters after it are
+ * cached, so that the scalar scanner would not read the input for it.
+ */
+
+static int
+yaml_parser_json_literal_length(yaml_parser_t *parser, size_t *length)
+{
+    *length = yaml_parser_plain_span(parser->buffer.pointer,
+            parser->unread-1, 1);
+
+    return (*length && *length+4 <= parser->unread
+            && (CHECK_AT(parser->buffer, ',', *length)
+                || CHECK_AT(parser->buffer, ']', *length)
+                || CHECK_AT(parser->buffer, '}', *length)));
+}
+
+/*
+ * Create a SCALAR token of the ASCII value at the given offset and skip the
+ * scalar together with its quotes.
+ */
+
+static int
+yaml_parser_scan_json_scalar(yaml_parser_t *parser, yaml_token_t *token,
+        size_t offset, size_t length, yaml_scalar_style_t style)
+{
+    yaml_mark_t start_mark, end_mark;
+    yaml_char_t *value;
+    int borrowed = 0;
+
+    /* Copy the value unless it may point into the input. */
+
+    if (parser->zero_copy && parser->buffer_storage.start) {
+        value = parser->buffer.pointer+offset;
+        borrowed = 1;
+    }
+    else {
+        value = ARENA_MALLOC(parser, length+1);
+        if (!value) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+        memcpy(value, parser->buffer.pointer+offset, length);
+        value[length] = '\0';
+    }
+
+    start_mark = MARK(parser);
+    SKIP_ASCII(parser, length+2*offset);
+    end_mark = MARK(parser);
+
+    SCALAR_TOKEN_INIT(*token, value, length, style, start_mark, end_mark);
+    token->data.scalar.borrowed = borrowed;
+    token->arena = (parser->arena != NULL);
+
+    return 1;
+}
+
+/*
+ * Check if an octet belongs to the rest of a line without further checks: an
+ * ASCII character other than a line break and NUL.  The reader lets no other
+ * control characters through.
+ */
+
+#define IS_LINE_ASCII(octet)                                                    \
+    (((octet) >= 0x20 && (octet) < 0x80) || (octet) == '\t')
+
+#if defined(YAML_HAVE_SSE2)
+
+static size_t
+yaml_parser_line_span_sse2(const yaml_char_t *pointer, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i tab = _mm_set1_epi8('\t');
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        __m128i octets = _mm_loadu_si128((const __m128i *)(pointer+k));
+        int mask;
 
-    parser->simple_key_allowed = 0;
+        /* Signed comparison: the octets above #x7F are negative. */
 
-    /* Create the SCALAR token and append it to the queue. */
+        __m128i stop = _mm_andnot_si128(_mm_cmpeq_epi8(octets, tab),
+                _mm_cmplt_epi8(octets, space));
 
-    if (!yaml_parser_scan_flow_scalar(parser, &token, single))
-        return 0;
+        mask = _mm_movemask_epi8(stop);
 
-    if (!ENQUEUE(parser, parser->tokens, token)) {
-        yaml_token_delete(&token);
-        return 0;
+        if (mask) {
+            while (!(mask & 1)) {
+                mask >>= 1;
+                k ++;
+            }
+            return k;
+        }
     }
 
-    return 1;
+    return k;
 }
 
-/*
- * Produce the SCALAR(...,plain) token.
- */
+#endif
 
-static int
-yaml_parser_fetch_plain_scalar(yaml_parser_t *parser)
+#if defined(YAML_HAVE_NEON)
+
+static size_t
+yaml_parser_line_span_neon(const yaml_char_t *pointer, size_t length)
 {
-    yaml_token_t token;
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    size_t k = 0;
 
-    /* A plain scalar could be a simple key. */
+    for (; k + 16 <= length; k += 16)
+    {
+        uint8x16_t octets = vld1q_u8(pointer+k);
+        uint8x16_t stop = vbicq_u8(vorrq_u8(vcltq_u8(octets, space),
+                    vcgeq_u8(octets, high)), vceqq_u8(octets, tab));
+        uint64x2_t lanes = vreinterpretq_u64_u8(stop);
 
-    if (!yaml_parser_save_simple_key(parser))
-        return 0;
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+            break;
+    }
 
-    /* A simple key cannot follow a flow scalar. */
+    return k;
+}
 
-    parser->simple_key_allowed = 0;
+#endif
 
-    /* Create the SCALAR token and append it to the queue. */
+/*
+ * Return the length of the run of octets at the beginning of the sequence
+ * that belong to the rest of a line without further checks, such as the body
+ * of a comment or a line of a block scalar.
+ */
 
-    if (!yaml_parser_scan_plain_scalar(parser, &token))
-        return 0;
+static size_t
+yaml_parser_line_span(const yaml_char_t *pointer, size_t length)
+{
+    size_t k = 0;
 
-    if (!ENQUEUE(parser, parser->tokens, token)) {
-        yaml_token_delete(&token);
-        return 0;
-    }
+#if defined(YAML_HAVE_SSE2)
+    k = yaml_parser_line_span_sse2(pointer, length);
+#elif defined(YAML_HAVE_NEON)
+    k = yaml_parser_line_span_neon(pointer, length);
+#endif
 
-    return 1;
+    while (k < length && IS_LINE_ASCII(pointer[k]))
+        k ++;
+
+    return k;
 }
 
 /*
@@ -1918,6 +2736,8 @@ yaml_parser_fetch_plain_scalar(yaml_parser_t *parser)
 static int
 yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 {
+    int tabs;
+
     /* Until the next token is not found. */
 
     while (1)
@@ -1926,7 +2746,7 @@ yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 
         if (!CACHE(parser, 1)) return 0;
 
-        if (parser->mark.column == 0 && IS_BOM(parser->buffer))
+        if (COLUMN(parser) == 0 && IS_BOM(parser->buffer))
             SKIP(parser);
 
         /*
@@ -1941,18 +2761,33 @@ yaml_parser_scan_to_next_token(yaml_parser_t *parser)
 
         if (!CACHE(parser, 1)) return 0;
 
-        while (CHECK(parser->buffer,' ') ||
-                ((parser->flow_level || !parser->simple_key_allowed) &&
-                 CHECK(parser->buffer, '\t'))) {
-            SKIP(parser);
+        tabs = (parser->flow_level || !parser->simple_key_allowed);
+
+        while (CHECK(parser->buffer,' ') || (tabs && CHECK(parser->buffer, '\t')))
+        {
+            size_t length = 1;
+
+            while (length < parser->unread
+                    && (parser->buffer.pointer[length] == ' '
+                        || (tabs && parser->buffer.pointer[length] == '\t')))
+                length ++;
+
+            SKIP_ASCII(parser, length);
             if (!CACHE(parser, 1)) return 0;
         }
 
-        /* Eat a comment until a line break. */
+        /* Eat a comment until a line break, skipping ASCII runs at once. */
 
         if (CHECK(parser->buffer, '#')) {
             while (!IS_BREAKZ(parser->buffer)) {
-                SKIP(parser);
+                size_t length = yaml_parser_line_span(parser->buffer.pointer,
+                        parser->unread);
+                if (length) {
+                    SKIP_ASCII(parser, length);
+                }
+                else {
+                    SKIP(parser);
+                }
                 if (!CACHE(parser, 1)) return 0;
             }
         }
@@ -2001,7 +2836,7 @@ yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token)
 
     /* Eat '%'. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     SKIP(parser);
 
@@ -2020,7 +2855,7 @@ yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token)
                     &major, &minor))
             goto error;
 
-        end_mark = parser->mark;
+        end_mark = MARK(parser);
 
         /* Create a VERSION-DIRECTIVE token. */
 
@@ -2038,12 +2873,13 @@ yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token)
                     &handle, &prefix))
             goto error;
 
-        end_mark = parser->mark;
+        end_mark = MARK(parser);
 
         /* Create a TAG-DIRECTIVE token. */
 
         TAG_DIRECTIVE_TOKEN_INIT(*token, handle, prefix,
                 start_mark, end_mark);
+        token->arena = (parser->arena != NULL);
     }
 
     /* Unknown directive. */
@@ -2091,8 +2927,8 @@ yaml_parser_scan_directive(yaml_parser_t *parser, yaml_token_t *token)
     return 1;
 
 error:
-    yaml_free(prefix);
-    yaml_free(handle);
+    ARENA_FREE(parser, prefix);
+    ARENA_FREE(parser, handle);
     yaml_free(name);
     return 0;
 }
@@ -2311,8 +3147,8 @@ yaml_parser_scan_tag_directive_value(yaml_parser_t *parser,
     return 1;
 
 error:
-    yaml_free(handle_value);
-    yaml_free(prefix_value);
+    ARENA_FREE(parser, handle_value);
+    ARENA_FREE(parser, prefix_value);
     return 0;
 }
 
@@ -2323,12 +3159,13 @@ yaml_parser_scan_anchor(yaml_parser_t *parser, yaml_token_t *token,
     int length = 0;
     yaml_mark_t start_mark, end_mark;
     yaml_string_t string = NULL_STRING;
+    yaml_char_t *value;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
 
     /* Eat the indicator character. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     SKIP(parser);
 
@@ -2342,7 +3179,7 @@ yaml_parser_scan_anchor(yaml_parser_t *parser, yaml_token_t *token,
         length ++;
     }
 
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /*
      * Check if length of the anchor is greater than 0 and it is followed by
@@ -2364,17 +3201,23 @@ yaml_parser_scan_anchor(yaml_parser_t *parser, yaml_token_t *token,
 
     /* Create a token. */
 
+    value = yaml_parser_copy_scalar(parser, &string);
+    if (!value) goto error;
+
     if (type == YAML_ANCHOR_TOKEN) {
-        ANCHOR_TOKEN_INIT(*token, string.start, start_mark, end_mark);
+        ANCHOR_TOKEN_INIT(*token, value, start_mark, end_mark);
     }
     else {
-        ALIAS_TOKEN_INIT(*token, string.start, start_mark, end_mark);
+        ALIAS_TOKEN_INIT(*token, value, start_mark, end_mark);
     }
+    token->arena = (parser->arena != NULL);
+
+    SCRATCH_GIVE(parser, string, scratch_string);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
+    SCRATCH_GIVE(parser, string, scratch_string);
     return 0;
 }
 
@@ -2389,7 +3232,7 @@ yaml_parser_scan_tag(yaml_parser_t *parser, yaml_token_t *token)
     yaml_char_t *suffix = NULL;
     yaml_mark_t start_mark, end_mark;
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     /* Check if the tag is in the canonical form. */
 
@@ -2399,7 +3242,7 @@ yaml_parser_scan_tag(yaml_parser_t *parser, yaml_token_t *token)
     {
         /* Set the handle to '' */
 
-        handle = YAML_MALLOC(1);
+        handle = ARENA_MALLOC(parser, 1);
         if (!handle) goto error;
         handle[0] = '\0';
 
@@ -2450,8 +3293,8 @@ yaml_parser_scan_tag(yaml_parser_t *parser, yaml_token_t *token)
 
             /* Set the handle to '!'. */
 
-            yaml_free(handle);
-            handle = YAML_MALLOC(2);
+            ARENA_FREE(parser, handle);
+            handle = ARENA_MALLOC(parser, 2);
             if (!handle) goto error;
             handle[0] = '!';
             handle[1] = '\0';
@@ -2479,17 +3322,18 @@ yaml_parser_scan_tag(yaml_parser_t *parser, yaml_token_t *token)
         goto error;
     }
 
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create a token. */
 
     TAG_TOKEN_INIT(*token, handle, suffix, start_mark, end_mark);
+    token->arena = (parser->arena != NULL);
 
     return 1;
 
 error:
-    yaml_free(handle);
-    yaml_free(suffix);
+    ARENA_FREE(parser, handle);
+    ARENA_FREE(parser, suffix);
     return 0;
 }
 
@@ -2503,7 +3347,7 @@ yaml_parser_scan_tag_handle(yaml_parser_t *parser, int directive,
 {
     yaml_string_t string = NULL_STRING;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
 
     /* Check the initial '!' character. */
 
@@ -2544,19 +3388,22 @@ yaml_parser_scan_tag_handle(yaml_parser_t *parser, int directive,
          * URI.
          */
 
-        if (directive && !(string.start[0] == '!' && string.start[1] == '\0')) {
+        if (directive && string.pointer - string.start != 1) {
             yaml_parser_set_scanner_error(parser, "while parsing a tag directive",
                     start_mark, "did not find expected '!'");
             goto error;
         }
     }
 
-    *handle = string.start;
+    *handle = yaml_parser_copy_scalar(parser, &string);
+    if (!*handle) goto error;
+
+    SCRATCH_GIVE(parser, string, scratch_string);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
+    SCRATCH_GIVE(parser, string, scratch_string);
     return 0;
 }
 
@@ -2571,7 +3418,7 @@ yaml_parser_scan_tag_uri(yaml_parser_t *parser, int directive,
     size_t length = head ? strlen((char *)head) : 0;
     yaml_string_t string = NULL_STRING;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
 
     /* Resize the string to include the head. */
 
@@ -2646,12 +3493,15 @@ yaml_parser_scan_tag_uri(yaml_parser_t *parser, int directive,
         goto error;
     }
 
-    *uri = string.start;
+    *uri = yaml_parser_copy_scalar(parser, &string);
+    if (!*uri) goto error;
+
+    SCRATCH_GIVE(parser, string, scratch_string);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
+    SCRATCH_GIVE(parser, string, scratch_string);
     return 0;
 }
 
@@ -2737,19 +3587,20 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
     yaml_string_t string = NULL_STRING;
     yaml_string_t leading_break = NULL_STRING;
     yaml_string_t trailing_breaks = NULL_STRING;
+    yaml_char_t *value;
     int chomping = 0;
     int increment = 0;
     int indent = 0;
     int leading_blank = 0;
     int trailing_blank = 0;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
+    if (!SCRATCH_TAKE(parser, leading_break, scratch_leading_break)) goto error;
+    if (!SCRATCH_TAKE(parser, trailing_breaks, scratch_trailing_breaks)) goto error;
 
     /* Eat the indicator '|' or '>'. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     SKIP(parser);
 
@@ -2843,7 +3694,7 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
         SKIP_LINE(parser);
     }
 
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Set the indentation level if it was specified. */
 
@@ -2860,7 +3711,7 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
     if (!CACHE(parser, 1)) goto error;
 
-    while ((int)parser->mark.column == indent && !(IS_Z(parser->buffer)))
+    while ((int)COLUMN(parser) == indent && !(IS_Z(parser->buffer)))
     {
         /*
          * We are at the beginning of a non-empty line.
@@ -2898,10 +3749,18 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
         leading_blank = IS_BLANK(parser->buffer);
 
-        /* Consume the current line. */
+        /* Consume the current line, copying ASCII runs at once. */
 
         while (!IS_BREAKZ(parser->buffer)) {
-            if (!READ(parser, string)) goto error;
+            size_t length = yaml_parser_line_span(parser->buffer.pointer,
+                    parser->unread);
+            if (length) {
+                if (!yaml_parser_read_ascii(parser, &string, length))
+                    goto error;
+            }
+            else {
+                if (!READ(parser, string)) goto error;
+            }
             if (!CACHE(parser, 1)) goto error;
         }
 
@@ -2928,19 +3787,24 @@ yaml_parser_scan_block_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
     /* Create a token. */
 
-    SCALAR_TOKEN_INIT(*token, string.start, string.pointer-string.start,
+    value = yaml_parser_copy_scalar(parser, &string);
+    if (!value) goto error;
+
+    SCALAR_TOKEN_INIT(*token, value, string.pointer-string.start,
             literal ? YAML_LITERAL_SCALAR_STYLE : YAML_FOLDED_SCALAR_STYLE,
             start_mark, end_mark);
+    token->arena = (parser->arena != NULL);
 
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
 
     return 0;
 }
@@ -2957,7 +3821,7 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
 {
     int max_indent = 0;
 
-    *end_mark = parser->mark;
+    *end_mark = MARK(parser);
 
     /* Eat the indentation spaces and line breaks. */
 
@@ -2967,18 +3831,18 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
 
         if (!CACHE(parser, 1)) return 0;
 
-        while ((!*indent || (int)parser->mark.column < *indent)
+        while ((!*indent || (int)COLUMN(parser) < *indent)
                 && IS_SPACE(parser->buffer)) {
             SKIP(parser);
             if (!CACHE(parser, 1)) return 0;
         }
 
-        if ((int)parser->mark.column > max_indent)
-            max_indent = (int)parser->mark.column;
+        if ((int)COLUMN(parser) > max_indent)
+            max_indent = (int)COLUMN(parser);
 
         /* Check for a tab character messing the indentation. */
 
-        if ((!*indent || (int)parser->mark.column < *indent)
+        if ((!*indent || (int)COLUMN(parser) < *indent)
                 && IS_TAB(parser->buffer)) {
             return yaml_parser_set_scanner_error(parser, "while scanning a block scalar",
                     start_mark, "found a tab character where an indentation space is expected");
@@ -2992,7 +3856,7 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
 
         if (!CACHE(parser, 2)) return 0;
         if (!READ_LINE(parser, *breaks)) return 0;
-        *end_mark = parser->mark;
+        *end_mark = MARK(parser);
     }
 
     /* Determine the indentation level if needed. */
@@ -3008,6 +3872,201 @@ yaml_parser_scan_block_scalar_breaks(yaml_parser_t *parser,
    return 1;
 }
 
+/*
+ * Copy the part of a scalar scanned in place so far to the scalar string.
+ *
+ * Scalars that are verbatim slices of a borrowed input are scanned without
+ * copying (see yaml_parser_set_zero_copy()).  As soon as a scalar needs
+ * folding or unescaping, the slice is copied and the scanning continues as
+ * usual.  Nothing is done if the scalar is not borrowed.
+ */
+
+static int
+yaml_parser_copy_borrowed(yaml_parser_t *parser, yaml_string_t *string,
+        yaml_char_t **borrowed, size_t length)
+{
+    if (!*borrowed)
+        return 1;
+
+    if (!SCRATCH_TAKE(parser, *string, scratch_string))
+        return 0;
+
+    while ((size_t)(string->end - string->start) <= length) {
+        if (!yaml_string_extend(&string->start, &string->pointer,
+                    &string->end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    memcpy(string->start, *borrowed, length);
+    string->pointer += length;
+
+    *borrowed = NULL;
+
+    return 1;
+}
+
+/*
+ * Copy the value of a scalar, an anchor or a tag out of the scratch string.
+ */
+
+static yaml_char_t *
+yaml_parser_copy_scalar(yaml_parser_t *parser, yaml_string_t *string)
+{
+    size_t length = string->pointer - string->start;
+    yaml_char_t *value = ARENA_MALLOC(parser, length+1);
+
+    if (!value) {
+        parser->error = YAML_MEMORY_ERROR;
+        return NULL;
+    }
+
+    memcpy(value, string->start, length);
+    value[length] = '\0';
+
+    return value;
+}
+
+/*
+ * Copy a run of ASCII characters to a string buffer and advance pointers.
+ */
+
+static int
+yaml_parser_read_ascii(yaml_parser_t *parser, yaml_string_t *string,
+        size_t length)
+{
+    while ((size_t)(string->end - string->pointer) <= length) {
+        if (!yaml_string_extend(&string->start, &string->pointer,
+                    &string->end)) {
+            parser->error = YAML_MEMORY_ERROR;
+            return 0;
+        }
+    }
+
+    memcpy(string->pointer, parser->buffer.pointer, length);
+    string->pointer += length;
+    SKIP_ASCII(parser, length);
+
+    return 1;
+}
+
+/*
+ * Check if an octet can be copied to a quoted scalar without further checks:
+ * a printable ASCII character or a tab other than '"', '\'' and '\\'.
+ */
+
+#define IS_QUOTED_ASCII(octet)                                                  \
+    ((((octet) >= 0x20 && (octet) < 0x7F) || (octet) == '\t')                  \
+     && (octet) != '"' && (octet) != '\'' && (octet) != '\\')
+
+#if defined(YAML_HAVE_SSE2)
+
+static size_t
+yaml_parser_quoted_span_sse2(const yaml_char_t *pointer, size_t length)
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i double_quote = _mm_set1_epi8('"');
+    const __m128i single_quote = _mm_set1_epi8('\'');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        __m128i octets = _mm_loadu_si128((const __m128i *)(pointer+k));
+        int mask;
+
+        /* Signed comparison: the octets above #x7F are negative. */
+
+        __m128i stop = _mm_andnot_si128(_mm_cmpeq_epi8(octets, tab),
+                _mm_cmplt_epi8(octets, space));
+
+        stop = _mm_or_si128(stop,
+                _mm_or_si128(_mm_cmpeq_epi8(octets, del),
+                    _mm_cmpeq_epi8(octets, double_quote)));
+        stop = _mm_or_si128(stop,
+                _mm_or_si128(_mm_cmpeq_epi8(octets, single_quote),
+                    _mm_cmpeq_epi8(octets, backslash)));
+
+        mask = _mm_movemask_epi8(stop);
+
+        if (mask) {
+            while (!(mask & 1)) {
+                mask >>= 1;
+                k ++;
+            }
+            return k;
+        }
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_NEON)
+
+static size_t
+yaml_parser_quoted_span_neon(const yaml_char_t *pointer, size_t length)
+{
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    const uint8x16_t double_quote = vdupq_n_u8('"');
+    const uint8x16_t single_quote = vdupq_n_u8('\'');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        uint8x16_t octets = vld1q_u8(pointer+k);
+        uint8x16_t stop = vbicq_u8(vorrq_u8(vcltq_u8(octets, space),
+                    vcgeq_u8(octets, del)), vceqq_u8(octets, tab));
+        uint64x2_t lanes;
+
+        stop = vorrq_u8(stop, vorrq_u8(vceqq_u8(octets, double_quote),
+                    vorrq_u8(vceqq_u8(octets, single_quote),
+                        vceqq_u8(octets, backslash))));
+
+        lanes = vreinterpretq_u64_u8(stop);
+
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+            break;
+    }
+
+    return k;
+}
+
+#endif
+
+/*
+ * Return the length of the run of octets at the beginning of the sequence
+ * that can be copied to a quoted scalar without further checks.  The run
+ * does not end with blanks, since the blanks before a line break are folded.
+ */
+
+static size_t
+yaml_parser_quoted_span(const yaml_char_t *pointer, size_t length)
+{
+    size_t k = 0;
+
+#if defined(YAML_HAVE_SSE2)
+    k = yaml_parser_quoted_span_sse2(pointer, length);
+#elif defined(YAML_HAVE_NEON)
+    k = yaml_parser_quoted_span_neon(pointer, length);
+#endif
+
+    while (k < length && IS_QUOTED_ASCII(pointer[k]))
+        k ++;
+
+    while (k && (pointer[k-1] == ' ' || pointer[k-1] == '\t'))
+        k --;
+
+    return k;
+}
+
 /*
  * Scan a quoted scalar.
  */
@@ -3022,19 +4081,29 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
     yaml_string_t leading_break = NULL_STRING;
     yaml_string_t trailing_breaks = NULL_STRING;
     yaml_string_t whitespaces = NULL_STRING;
+    yaml_char_t *borrowed = NULL;
+    size_t borrowed_length = 0;
     int leading_blanks;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, whitespaces, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, leading_break, scratch_leading_break)) goto error;
+    if (!SCRATCH_TAKE(parser, trailing_breaks, scratch_trailing_breaks)) goto error;
+    if (!SCRATCH_TAKE(parser, whitespaces, scratch_whitespaces)) goto error;
 
     /* Eat the left quote. */
 
-    start_mark = parser->mark;
+    start_mark = MARK(parser);
 
     SKIP(parser);
 
+    /* Scan the scalar in place if the input is borrowed. */
+
+    if (parser->zero_copy && parser->buffer_storage.start) {
+        borrowed = parser->buffer.pointer;
+    }
+    else {
+        if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
+    }
+
     /* Consume the content of the quoted scalar. */
 
     while (1)
@@ -3043,7 +4112,7 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
         if (!CACHE(parser, 4)) goto error;
 
-        if (parser->mark.column == 0 &&
+        if (COLUMN(parser) == 0 &&
             ((CHECK_AT(parser->buffer, '-', 0) &&
               CHECK_AT(parser->buffer, '-', 1) &&
               CHECK_AT(parser->buffer, '-', 2)) ||
@@ -3078,6 +4147,8 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
             if (single && CHECK_AT(parser->buffer, '\'', 0)
                     && CHECK_AT(parser->buffer, '\'', 1))
             {
+                if (!yaml_parser_copy_borrowed(parser, &string,
+                            &borrowed, borrowed_length)) goto error;
                 if (!STRING_EXTEND(parser, string)) goto error;
                 *(string.pointer++) = '\'';
                 SKIP(parser);
@@ -3096,6 +4167,8 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
             else if (!single && CHECK(parser->buffer, '\\')
                     && IS_BREAK_AT(parser->buffer, 1))
             {
+                if (!yaml_parser_copy_borrowed(parser, &string,
+                            &borrowed, borrowed_length)) goto error;
                 if (!CACHE(parser, 3)) goto error;
                 SKIP(parser);
                 SKIP_LINE(parser);
@@ -3109,6 +4182,8 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
             {
                 size_t code_length = 0;
 
+                if (!yaml_parser_copy_borrowed(parser, &string,
+                            &borrowed, borrowed_length)) goto error;
                 if (!STRING_EXTEND(parser, string)) goto error;
 
                 /* Check the escape character. */
@@ -3270,7 +4345,33 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
             {
                 /* It is a non-escaped non-blank character. */
 
-                if (!READ(parser, string)) goto error;
+                if (borrowed) {
+                    borrowed_length += WIDTH(parser->buffer);
+                    SKIP(parser);
+                }
+                else {
+                    if (!READ(parser, string)) goto error;
+                }
+
+                /*
+                 * Copy the following run of ordinary characters and inner
+                 * blanks at once, short of the last cached character.
+                 */
+
+                if (parser->unread > 1)
+                {
+                    size_t length = yaml_parser_quoted_span(
+                            parser->buffer.pointer, parser->unread-1);
+
+                    if (borrowed) {
+                        borrowed_length += length;
+                        SKIP_ASCII(parser, length);
+                    }
+                    else {
+                        if (!yaml_parser_read_ascii(parser, &string, length))
+                            goto error;
+                    }
+                }
             }
 
             if (!CACHE(parser, 2)) goto error;
@@ -3327,6 +4428,9 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
         if (leading_blanks)
         {
+            if (!yaml_parser_copy_borrowed(parser, &string,
+                        &borrowed, borrowed_length)) goto error;
+
             /* Do we need to fold line breaks? */
 
             if (leading_break.start[0] == '\n') {
@@ -3347,6 +4451,11 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
                 CLEAR(parser, trailing_breaks);
             }
         }
+        else if (borrowed)
+        {
+            borrowed_length += whitespaces.pointer - whitespaces.start;
+            CLEAR(parser, whitespaces);
+        }
         else
         {
             if (!JOIN(parser, string, whitespaces)) goto error;
@@ -3358,29 +4467,166 @@ yaml_parser_scan_flow_scalar(yaml_parser_t *parser, yaml_token_t *token,
 
     SKIP(parser);
 
-    end_mark = parser->mark;
+    end_mark = MARK(parser);
 
     /* Create a token. */
 
-    SCALAR_TOKEN_INIT(*token, string.start, string.pointer-string.start,
-            single ? YAML_SINGLE_QUOTED_SCALAR_STYLE : YAML_DOUBLE_QUOTED_SCALAR_STYLE,
-            start_mark, end_mark);
+    if (borrowed) {
+        SCALAR_TOKEN_INIT(*token, borrowed, borrowed_length,
+                single ? YAML_SINGLE_QUOTED_SCALAR_STYLE : YAML_DOUBLE_QUOTED_SCALAR_STYLE,
+                start_mark, end_mark);
+        token->data.scalar.borrowed = 1;
+    }
+    else {
+        yaml_char_t *value = yaml_parser_copy_scalar(parser, &string);
+        if (!value) goto error;
+        SCALAR_TOKEN_INIT(*token, value, string.pointer-string.start,
+                single ? YAML_SINGLE_QUOTED_SCALAR_STYLE : YAML_DOUBLE_QUOTED_SCALAR_STYLE,
+                start_mark, end_mark);
+        token->arena = (parser->arena != NULL);
+    }
 
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
-    STRING_DEL(parser, whitespaces);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
+    SCRATCH_GIVE(parser, whitespaces, scratch_whitespaces);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
-    STRING_DEL(parser, whitespaces);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
+    SCRATCH_GIVE(parser, whitespaces, scratch_whitespaces);
 
     return 0;
 }
 
+/*
+ * Check if an octet can be copied to a plain scalar without further checks:
+ * a printable ASCII character other than a blank, ':' and, in the flow
+ * context, one of ',?[]{}'.
+ */
+
+#define IS_PLAIN_ASCII(octet,flow)                                              \
+    ((octet) > 0x20 && (octet) < 0x7F && (octet) != ':'                        \
+     && !((flow) && (yaml_char_classes[octet] & YAML_CHAR_FLOW_INDICATOR)))
+
+#if defined(YAML_HAVE_SSE2)
+
+static size_t
+yaml_parser_plain_span_sse2(const yaml_char_t *pointer, size_t length,
+        int flow)
+{
+    const __m128i blank = _mm_set1_epi8(0x21);
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i question = _mm_set1_epi8('?');
+    const __m128i brackets = _mm_set1_epi8(0x20);  /* '[' | 0x20 == '{' */
+    const __m128i left = _mm_set1_epi8('{');
+    const __m128i right = _mm_set1_epi8('}');
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        __m128i octets = _mm_loadu_si128((const __m128i *)(pointer+k));
+        int mask;
+
+        /* Signed comparison: the octets above #x7F are negative. */
+
+        __m128i stop = _mm_or_si128(_mm_cmplt_epi8(octets, blank),
+                _mm_cmpeq_epi8(octets, colon));
+
+        if (flow) {
+            __m128i folded = _mm_or_si128(octets, brackets);
+            stop = _mm_or_si128(stop,
+                    _mm_or_si128(_mm_cmpeq_epi8(octets, comma),
+                        _mm_cmpeq_epi8(octets, question)));
+            stop = _mm_or_si128(stop,
+                    _mm_or_si128(_mm_cmpeq_epi8(folded, left),
+                        _mm_cmpeq_epi8(folded, right)));
+        }
+
+        mask = _mm_movemask_epi8(stop);
+
+        if (mask) {
+            while (!(mask & 1)) {
+                mask >>= 1;
+                k ++;
+            }
+            return k;
+        }
+    }
+
+    return k;
+}
+
+#endif
+
+#if defined(YAML_HAVE_NEON)
+
+static size_t
+yaml_parser_plain_span_neon(const yaml_char_t *pointer, size_t length,
+        int flow)
+{
+    const uint8x16_t blank = vdupq_n_u8(0x21);
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    const uint8x16_t colon = vdupq_n_u8(':');
+    const uint8x16_t comma = vdupq_n_u8(',');
+    const uint8x16_t question = vdupq_n_u8('?');
+    const uint8x16_t brackets = vdupq_n_u8(0x20);
+    const uint8x16_t left = vdupq_n_u8('{');
+    const uint8x16_t right = vdupq_n_u8('}');
+    size_t k = 0;
+
+    for (; k + 16 <= length; k += 16)
+    {
+        uint8x16_t octets = vld1q_u8(pointer+k);
+        uint8x16_t stop = vorrq_u8(vorrq_u8(vcltq_u8(octets, blank),
+                    vcgeq_u8(octets, del)), vceqq_u8(octets, colon));
+        uint64x2_t lanes;
+
+        if (flow) {
+            uint8x16_t folded = vorrq_u8(octets, brackets);
+            stop = vorrq_u8(stop, vorrq_u8(vceqq_u8(octets, comma),
+                        vceqq_u8(octets, question)));
+            stop = vorrq_u8(stop, vorrq_u8(vceqq_u8(folded, left),
+                        vceqq_u8(folded, right)));
+        }
+
+        lanes = vreinterpretq_u64_u8(stop);
+
+        if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+            break;
+    }
+
+    return k;
+}
+
+#endif
+
+/*
+ * Return the length of the run of octets at the beginning of the sequence
+ * that can be copied to a plain scalar without further checks.
+ */
+
+static size_t
+yaml_parser_plain_span(const yaml_char_t *pointer, size_t length, int flow)
+{
+    size_t k = 0;
+
+#if defined(YAML_HAVE_SSE2)
+    k = yaml_parser_plain_span_sse2(pointer, length, flow);
+#elif defined(YAML_HAVE_NEON)
+    k = yaml_parser_plain_span_neon(pointer, length, flow);
+#endif
+
+    while (k < length && IS_PLAIN_ASCII(pointer[k], flow))
+        k ++;
+
+    return k;
+}
+
 /*
  * Scan a plain scalar.
  */
@@ -3394,15 +4640,25 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
     yaml_string_t leading_break = NULL_STRING;
     yaml_string_t trailing_breaks = NULL_STRING;
     yaml_string_t whitespaces = NULL_STRING;
+    yaml_char_t *borrowed = NULL;
+    size_t borrowed_length = 0;
     int leading_blanks = 0;
     int indent = parser->indent+1;
 
-    if (!STRING_INIT(parser, string, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, leading_break, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, trailing_breaks, INITIAL_STRING_SIZE)) goto error;
-    if (!STRING_INIT(parser, whitespaces, INITIAL_STRING_SIZE)) goto error;
+    if (!SCRATCH_TAKE(parser, leading_break, scratch_leading_break)) goto error;
+    if (!SCRATCH_TAKE(parser, trailing_breaks, scratch_trailing_breaks)) goto error;
+    if (!SCRATCH_TAKE(parser, whitespaces, scratch_whitespaces)) goto error;
+
+    /* Scan the scalar in place if the input is borrowed. */
+
+    if (parser->zero_copy && parser->buffer_storage.start) {
+        borrowed = parser->buffer.pointer;
+    }
+    else {
+        if (!SCRATCH_TAKE(parser, string, scratch_string)) goto error;
+    }
 
-    start_mark = end_mark = parser->mark;
+    start_mark = end_mark = MARK(parser);
 
     /* Consume the content of the plain scalar. */
 
@@ -3412,7 +4668,7 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
 
         if (!CACHE(parser, 4)) goto error;
 
-        if (parser->mark.column == 0 &&
+        if (COLUMN(parser) == 0 &&
             ((CHECK_AT(parser->buffer, '-', 0) &&
               CHECK_AT(parser->buffer, '-', 1) &&
               CHECK_AT(parser->buffer, '-', 2)) ||
@@ -3437,15 +4693,7 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
 
             if (parser->flow_level
                     && CHECK(parser->buffer, ':')
-                    && (
-                        CHECK_AT(parser->buffer, ',', 1)
-                        || CHECK_AT(parser->buffer, '?', 1)
-                        || CHECK_AT(parser->buffer, '[', 1)
-                        || CHECK_AT(parser->buffer, ']', 1)
-                        || CHECK_AT(parser->buffer, '{', 1)
-                        || CHECK_AT(parser->buffer, '}', 1)
-                    )
-                    ) {
+                    && IS_CLASS_AT(parser->buffer, YAML_CHAR_FLOW_INDICATOR, 1)) {
                 yaml_parser_set_scanner_error(parser, "while scanning a plain scalar",
                         start_mark, "found unexpected ':'");
                 goto error;
@@ -3454,11 +4702,8 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
             /* Check for indicators that may end a plain scalar. */
 
             if ((CHECK(parser->buffer, ':') && IS_BLANKZ_AT(parser->buffer, 1))
-                    || (parser->flow_level &&
-                        (CHECK(parser->buffer, ',')
-                         || CHECK(parser->buffer, '?') || CHECK(parser->buffer, '[')
-                         || CHECK(parser->buffer, ']') || CHECK(parser->buffer, '{')
-                         || CHECK(parser->buffer, '}'))))
+                    || (parser->flow_level && IS_CLASS_AT(parser->buffer,
+                            YAML_CHAR_FLOW_INDICATOR, 0)))
                 break;
 
             /* Check if we need to join whitespaces and breaks. */
@@ -3467,6 +4712,9 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
             {
                 if (leading_blanks)
                 {
+                    if (!yaml_parser_copy_borrowed(parser, &string,
+                                &borrowed, borrowed_length)) goto error;
+
                     /* Do we need to fold line breaks? */
 
                     if (leading_break.start[0] == '\n') {
@@ -3489,6 +4737,11 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
 
                     leading_blanks = 0;
                 }
+                else if (borrowed)
+                {
+                    borrowed_length += whitespaces.pointer - whitespaces.start;
+                    CLEAR(parser, whitespaces);
+                }
                 else
                 {
                     if (!JOIN(parser, string, whitespaces)) goto error;
@@ -3498,9 +4751,36 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
 
             /* Copy the character. */
 
-            if (!READ(parser, string)) goto error;
+            if (borrowed) {
+                borrowed_length += WIDTH(parser->buffer);
+                SKIP(parser);
+            }
+            else {
+                if (!READ(parser, string)) goto error;
+            }
+
+            /*
+             * Copy the following run of ordinary characters at once.  The
+             * run stops short of the last cached character, so the buffer is
+             * refilled exactly when it would be character by character.
+             */
+
+            if (parser->unread > 1)
+            {
+                size_t length = yaml_parser_plain_span(parser->buffer.pointer,
+                        parser->unread-1, parser->flow_level);
+
+                if (borrowed) {
+                    borrowed_length += length;
+                    SKIP_ASCII(parser, length);
+                }
+                else {
+                    if (!yaml_parser_read_ascii(parser, &string, length))
+                        goto error;
+                }
+            }
 
-            end_mark = parser->mark;
+            end_mark = MARK(parser);
 
             if (!CACHE(parser, 2)) goto error;
         }
@@ -3520,7 +4800,7 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
             {
                 /* Check for tab characters that abuse indentation. */
 
-                if (leading_blanks && (int)parser->mark.column < indent
+                if (leading_blanks && (int)COLUMN(parser) < indent
                         && IS_TAB(parser->buffer)) {
                     yaml_parser_set_scanner_error(parser, "while scanning a plain scalar",
                             start_mark, "found a tab character that violate indentation");
@@ -3558,14 +4838,24 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
 
         /* Check indentation level. */
 
-        if (!parser->flow_level && (int)parser->mark.column < indent)
+        if (!parser->flow_level && (int)COLUMN(parser) < indent)
             break;
     }
 
     /* Create a token. */
 
-    SCALAR_TOKEN_INIT(*token, string.start, string.pointer-string.start,
-            YAML_PLAIN_SCALAR_STYLE, start_mark, end_mark);
+    if (borrowed) {
+        SCALAR_TOKEN_INIT(*token, borrowed, borrowed_length,
+                YAML_PLAIN_SCALAR_STYLE, start_mark, end_mark);
+        token->data.scalar.borrowed = 1;
+    }
+    else {
+        yaml_char_t *value = yaml_parser_copy_scalar(parser, &string);
+        if (!value) goto error;
+        SCALAR_TOKEN_INIT(*token, value, string.pointer-string.start,
+                YAML_PLAIN_SCALAR_STYLE, start_mark, end_mark);
+        token->arena = (parser->arena != NULL);
+    }
 
     /* Note that we change the 'simple_key_allowed' flag. */
 
@@ -3573,17 +4863,18 @@ yaml_parser_scan_plain_scalar(yaml_parser_t *parser, yaml_token_t *token)
         parser->simple_key_allowed = 1;
     }
 
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
-    STRING_DEL(parser, whitespaces);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
+    SCRATCH_GIVE(parser, whitespaces, scratch_whitespaces);
 
     return 1;
 
 error:
-    STRING_DEL(parser, string);
-    STRING_DEL(parser, leading_break);
-    STRING_DEL(parser, trailing_breaks);
-    STRING_DEL(parser, whitespaces);
+    SCRATCH_GIVE(parser, string, scratch_string);
+    SCRATCH_GIVE(parser, leading_break, scratch_leading_break);
+    SCRATCH_GIVE(parser, trailing_breaks, scratch_trailing_breaks);
+    SCRATCH_GIVE(parser, whitespaces, scratch_whitespaces);
 
     return 0;
 }
@@ -8,6 +8,40 @@
 #include <limits.h>
 #include <stddef.h>
 
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+/*
+ * SIMD support.
+ *
+ * SSE2 and NEON are selected at compile time.  AVX2 is only compiled in for
+ * GCC-compatible compilers and is selected at run time.  Define
+ * YAML_DISABLE_SIMD to build the portable code only.
+ */
+
+#if !defined(YAML_DISABLE_SIMD)
+#   if defined(__SSE2__) || defined(_M_X64)                                    \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define YAML_HAVE_SSE2
+#       include <emmintrin.h>
+#       if (defined(__GNUC__) || defined(__clang__))                           \
+            && (defined(__x86_64__) || defined(__i386__))
+#           define YAML_HAVE_AVX2
+#           include <immintrin.h>
+#       endif
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#       define YAML_HAVE_NEON
+#       include <arm_neon.h>
+#   endif
+#endif
+
 /*
  * Memory management.
  */
@@ -24,6 +58,44 @@ yaml_free(void *ptr);
 YAML_DECLARE(yaml_char_t *)
 yaml_strdup(const yaml_char_t *);
 
+YAML_DECLARE(size_t)
+yaml_hash(const yaml_char_t *string, size_t length);
+
+/*
+ * An arena of chunks that strings and small objects are bump-allocated from.
+ *
+ * The chunks in use form a list from the oldest to the current one.  The
+ * released chunks of the default size are kept for reuse; larger ones, which
+ * hold a single long string each, are freed.
+ */
+
+typedef struct yaml_arena_chunk_s {
+    struct yaml_arena_chunk_s *next;    /* The next chunk of the list. */
+    size_t size;                        /* The size of the chunk data. */
+} yaml_arena_chunk_t;
+
+struct yaml_arena_s {
+    size_t size;                        /* The default size of a chunk. */
+    yaml_arena_chunk_t *head;           /* The oldest chunk in use. */
+    yaml_arena_chunk_t *tail;           /* The current chunk. */
+    yaml_arena_chunk_t *spare;          /* The released chunks. */
+    char *pointer;                      /* The free space of the current chunk. */
+    char *end;                          /* The end of the current chunk. */
+};
+
+YAML_DECLARE(void *)
+yaml_arena_malloc(struct yaml_arena_s *arena, size_t size);
+
+YAML_DECLARE(void)
+yaml_arena_release(struct yaml_arena_s *arena, yaml_arena_chunk_t *live);
+
+YAML_DECLARE(void)
+yaml_arena_delete(struct yaml_arena_s *arena);
+
+YAML_DECLARE(int)
+yaml_arena_stack_extend(struct yaml_arena_s *arena,
+        void **start, void **top, void **end, size_t size);
+
 /*
  * Reader: Ensure that the buffer contains at least `length` characters.
  */
@@ -31,6 +103,22 @@ yaml_strdup(const yaml_char_t *);
 YAML_DECLARE(int)
 yaml_parser_update_buffer(yaml_parser_t *parser, size_t length);
 
+/*
+ * Reader: The read handler of a string input.
+ */
+
+YAML_DECLARE(int)
+yaml_string_read_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read);
+
+/*
+ * Reader: The read handler of a pushed input.
+ */
+
+YAML_DECLARE(int)
+yaml_feed_read_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read);
+
 /*
  * Scanner: Ensure that the token stack contains at least one token ready.
  */
@@ -38,6 +126,13 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length);
 YAML_DECLARE(int)
 yaml_parser_fetch_more_tokens(yaml_parser_t *parser);
 
+/*
+ * Scanner: Move the unparsed tokens to the beginning of the queue.
+ */
+
+YAML_DECLARE(void)
+yaml_parser_compact_tokens(yaml_parser_t *parser);
+
 /*
  * The size of the input raw buffer.
  */
@@ -52,6 +147,43 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser);
 
 #define INPUT_BUFFER_SIZE       (INPUT_RAW_BUFFER_SIZE*3)
 
+/*
+ * The room that must be left at the end of the input buffer before it is
+ * refilled.
+ *
+ * Decoding the raw buffer takes up to one and a half times its size, so the
+ * unread characters need not be moved to the beginning of the buffer on every
+ * refill.
+ */
+
+#define INPUT_BUFFER_RESERVE    (INPUT_RAW_BUFFER_SIZE*2)
+
+/*
+ * The number of octets of a borrowed input that are handed to the scanner at
+ * once.  The pages of a memory-mapped input are released in the same steps.
+ */
+
+#define INPUT_WINDOW_SIZE       (1024*1024)
+
+/*
+ * The default number and size of the chunks read ahead of the parser.
+ */
+
+#define READ_AHEAD_CHUNK_COUNT  4
+#define READ_AHEAD_CHUNK_SIZE   (64*1024)
+
+/*
+ * The number of tokens of a JSON text queued ahead from the cached input.
+ */
+
+#define JSON_TOKEN_RUN          64
+
+/*
+ * The default size of an arena chunk.
+ */
+
+#define ARENA_CHUNK_SIZE        (64*1024)
+
 /*
  * The size of the output buffer.
  */
@@ -84,6 +216,13 @@ yaml_parser_fetch_more_tokens(yaml_parser_t *parser);
 #define INITIAL_STACK_SIZE  16
 #define INITIAL_QUEUE_SIZE  16
 #define INITIAL_STRING_SIZE 16
+#define INITIAL_TABLE_SIZE  32
+
+/*
+ * The number of pairs from which mappings are looked up in a hash table.
+ */
+
+#define MAPPING_INDEX_THRESHOLD 8
 
 /*
  * Buffer management.
@@ -152,7 +291,7 @@ yaml_string_join(
 
 #define CLEAR(context,string)                                                   \
     ((string).pointer = (string).start,                                         \
-     memset((string).start, 0, (string).end-(string).start))
+     *(string).start = '\0')
 
 #define JOIN(context,string_a,string_b)                                         \
     ((yaml_string_join(&(string_a).start, &(string_a).pointer,                  \
@@ -180,20 +319,42 @@ yaml_string_join(
 
 #define CHECK(string,octet) (CHECK_AT((string),(octet),0))
 
+/*
+ * The character classes of the octets.
+ *
+ * A multi-octet line break (NEL, LS, PS) or a printable character whose
+ * leading octet is not enough to decide is marked by its leading octet; the
+ * following octets are checked only for these.
+ */
+
+#define YAML_CHAR_ALPHA             0x001   /* [0-9A-Za-z_-] */
+#define YAML_CHAR_DIGIT             0x002   /* [0-9] */
+#define YAML_CHAR_HEX               0x004   /* [0-9A-Fa-f] */
+#define YAML_CHAR_SPACE             0x008   /* ' ' */
+#define YAML_CHAR_TAB               0x010   /* '\t' */
+#define YAML_CHAR_BREAK             0x020   /* '\r', '\n' */
+#define YAML_CHAR_Z                 0x040   /* '\0' */
+#define YAML_CHAR_BREAK_LEAD        0x080   /* #xC2, #xE2 */
+#define YAML_CHAR_PRINTABLE         0x100
+#define YAML_CHAR_PRINTABLE_LEAD    0x200   /* #xC2, #xED, #xEF */
+#define YAML_CHAR_FLOW_INDICATOR    0x400   /* ',', '?', '[', ']', '{', '}' */
+
+extern const unsigned short yaml_char_classes[256];
+
+/*
+ * Check if the octet at the specified position belongs to any of the classes.
+ */
+
+#define IS_CLASS_AT(string,classes,offset)                                      \
+    (yaml_char_classes[(string).pointer[offset]] & (classes))
+
 /*
  * Check if the character at the specified position is an alphabetical
  * character, a digit, '_', or '-'.
  */
 
 #define IS_ALPHA_AT(string,offset)                                              \
-     (((string).pointer[offset] >= (yaml_char_t) '0' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) '9') ||                        \
-      ((string).pointer[offset] >= (yaml_char_t) 'A' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) 'Z') ||                        \
-      ((string).pointer[offset] >= (yaml_char_t) 'a' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) 'z') ||                        \
-      (string).pointer[offset] == '_' ||                                        \
-      (string).pointer[offset] == '-')
+    IS_CLASS_AT((string),YAML_CHAR_ALPHA,(offset))
 
 #define IS_ALPHA(string)    IS_ALPHA_AT((string),0)
 
@@ -202,8 +363,7 @@ yaml_string_join(
  */
 
 #define IS_DIGIT_AT(string,offset)                                              \
-     (((string).pointer[offset] >= (yaml_char_t) '0' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) '9'))
+    IS_CLASS_AT((string),YAML_CHAR_DIGIT,(offset))
 
 #define IS_DIGIT(string)    IS_DIGIT_AT((string),0)
 
@@ -221,12 +381,7 @@ yaml_string_join(
  */
 
 #define IS_HEX_AT(string,offset)                                                \
-     (((string).pointer[offset] >= (yaml_char_t) '0' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) '9') ||                        \
-      ((string).pointer[offset] >= (yaml_char_t) 'A' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) 'F') ||                        \
-      ((string).pointer[offset] >= (yaml_char_t) 'a' &&                         \
-       (string).pointer[offset] <= (yaml_char_t) 'f'))
+    IS_CLASS_AT((string),YAML_CHAR_HEX,(offset))
 
 #define IS_HEX(string)    IS_HEX_AT((string),0)
 
@@ -259,22 +414,18 @@ yaml_string_join(
  */
 
 #define IS_PRINTABLE_AT(string,offset)                                          \
-    (((string).pointer[offset] == 0x0A)         /* . == #x0A */                 \
-     || ((string).pointer[offset] >= 0x20       /* #x20 <= . <= #x7E */         \
-         && (string).pointer[offset] <= 0x7E)                                   \
-     || ((string).pointer[offset] == 0xC2       /* #0xA0 <= . <= #xD7FF */      \
-         && (string).pointer[offset+1] >= 0xA0)                                 \
-     || ((string).pointer[offset] > 0xC2                                        \
-         && (string).pointer[offset] < 0xED)                                    \
-     || ((string).pointer[offset] == 0xED                                       \
-         && (string).pointer[offset+1] < 0xA0)                                  \
-     || ((string).pointer[offset] == 0xEE)                                      \
-     || ((string).pointer[offset] == 0xEF      /* #xE000 <= . <= #xFFFD */      \
-         && !((string).pointer[offset+1] == 0xBB        /* && . != #xFEFF */    \
-             && (string).pointer[offset+2] == 0xBF)                             \
-         && !((string).pointer[offset+1] == 0xBF                                \
-             && ((string).pointer[offset+2] == 0xBE                             \
-                 || (string).pointer[offset+2] == 0xBF))))
+    (IS_CLASS_AT((string),YAML_CHAR_PRINTABLE,(offset))                         \
+     || (IS_CLASS_AT((string),YAML_CHAR_PRINTABLE_LEAD,(offset))                \
+         && (((string).pointer[offset] == 0xC2  /* #0xA0 <= . <= #xD7FF */      \
+                 && (string).pointer[offset+1] >= 0xA0)                         \
+             || ((string).pointer[offset] == 0xED                               \
+                 && (string).pointer[offset+1] < 0xA0)                          \
+             || ((string).pointer[offset] == 0xEF /* #xE000 <= . <= #xFFFD */   \
+                 && !((string).pointer[offset+1] == 0xBB    /* && . != #xFEFF */\
+                     && (string).pointer[offset+2] == 0xBF)                     \
+                 && !((string).pointer[offset+1] == 0xBF                        \
+                     && ((string).pointer[offset+2] == 0xBE                     \
+                         || (string).pointer[offset+2] == 0xBF))))))
 
 #define IS_PRINTABLE(string)    IS_PRINTABLE_AT((string),0)
 
@@ -318,25 +469,41 @@ yaml_string_join(
  */
 
 #define IS_BLANK_AT(string,offset)                                              \
-    (IS_SPACE_AT((string),(offset)) || IS_TAB_AT((string),(offset)))
+    IS_CLASS_AT((string),YAML_CHAR_SPACE|YAML_CHAR_TAB,(offset))
 
 #define IS_BLANK(string)    IS_BLANK_AT((string),0)
 
 /*
- * Check if the character at the specified position is a line break.
+ * Check if the character at the specified position is a multi-octet line
+ * break.
  */
 
-#define IS_BREAK_AT(string,offset)                                              \
-    (CHECK_AT((string),'\r',(offset))               /* CR (#xD)*/               \
-     || CHECK_AT((string),'\n',(offset))            /* LF (#xA) */              \
-     || (CHECK_AT((string),'\xC2',(offset))                                     \
-         && CHECK_AT((string),'\x85',(offset)+1))   /* NEL (#x85) */            \
-     || (CHECK_AT((string),'\xE2',(offset))                                     \
-         && CHECK_AT((string),'\x80',(offset)+1)                                \
-         && CHECK_AT((string),'\xA8',(offset)+2))   /* LS (#x2028) */           \
+#define IS_WIDE_BREAK_AT(string,offset)                                         \
+    ((CHECK_AT((string),'\xC2',(offset))                                        \
+      && CHECK_AT((string),'\x85',(offset)+1))      /* NEL (#x85) */            \
      || (CHECK_AT((string),'\xE2',(offset))                                     \
          && CHECK_AT((string),'\x80',(offset)+1)                                \
-         && CHECK_AT((string),'\xA9',(offset)+2)))  /* PS (#x2029) */
+         && (CHECK_AT((string),'\xA8',(offset)+2)   /* LS (#x2028) */           \
+             || CHECK_AT((string),'\xA9',(offset)+2)))) /* PS (#x2029) */
+
+/*
+ * Check if the character at the specified position belongs to any of the
+ * classes or is a multi-octet line break.  A single table lookup decides for
+ * all octets but the leading octets of NEL, LS, and PS.
+ */
+
+#define IS_CLASS_OR_BREAK_AT(string,classes,offset)                             \
+    (IS_CLASS_AT((string),(classes)|YAML_CHAR_BREAK|YAML_CHAR_BREAK_LEAD,       \
+                 (offset))                                                      \
+     && (!IS_CLASS_AT((string),YAML_CHAR_BREAK_LEAD,(offset))                   \
+         || IS_WIDE_BREAK_AT((string),(offset))))
+
+/*
+ * Check if the character at the specified position is a line break.
+ */
+
+#define IS_BREAK_AT(string,offset)                                              \
+    IS_CLASS_OR_BREAK_AT((string),0,(offset))
 
 #define IS_BREAK(string)    IS_BREAK_AT((string),0)
 
@@ -350,7 +517,7 @@ yaml_string_join(
  */
 
 #define IS_BREAKZ_AT(string,offset)                                             \
-    (IS_BREAK_AT((string),(offset)) || IS_Z_AT((string),(offset)))
+    IS_CLASS_OR_BREAK_AT((string),YAML_CHAR_Z,(offset))
 
 #define IS_BREAKZ(string)   IS_BREAKZ_AT((string),0)
 
@@ -359,7 +526,7 @@ yaml_string_join(
  */
 
 #define IS_SPACEZ_AT(string,offset)                                             \
-    (IS_SPACE_AT((string),(offset)) || IS_BREAKZ_AT((string),(offset)))
+    IS_CLASS_OR_BREAK_AT((string),YAML_CHAR_SPACE|YAML_CHAR_Z,(offset))
 
 #define IS_SPACEZ(string)   IS_SPACEZ_AT((string),0)
 
@@ -368,7 +535,8 @@ yaml_string_join(
  */
 
 #define IS_BLANKZ_AT(string,offset)                                             \
-    (IS_BLANK_AT((string),(offset)) || IS_BREAKZ_AT((string),(offset)))
+    IS_CLASS_OR_BREAK_AT((string),                                              \
+            YAML_CHAR_SPACE|YAML_CHAR_TAB|YAML_CHAR_Z,(offset))
 
 #define IS_BLANKZ(string)   IS_BLANKZ_AT((string),0)
 
@@ -450,6 +618,18 @@ yaml_queue_extend(void **start, void **head, void **tail, void **end);
         ((context)->error = YAML_MEMORY_ERROR,                                  \
          0))
 
+#define DOCUMENT_PUSH(context,document,stack,value)                             \
+    (!(document)->arena ?                                                       \
+        PUSH((context),(stack),(value)) :                                       \
+     ((stack).top != (stack).end                                                \
+      || yaml_arena_stack_extend((document)->arena,                             \
+              (void **)&(stack).start, (void **)&(stack).top,                   \
+              (void **)&(stack).end, sizeof(*(stack).start))) ?                 \
+        (*((stack).top++) = value,                                              \
+         1) :                                                                   \
+        ((context)->error = YAML_MEMORY_ERROR,                                  \
+         0))
+
 #define POP(context,stack)                                                      \
     (*(--(stack).top))
 
@@ -682,3 +862,29 @@ yaml_queue_extend(void **start, void **head, void **tail, void **end);
 
 #define YAML_MALLOC_STATIC(type) (type*)yaml_malloc(sizeof(type))
 #define YAML_MALLOC(size)        (yaml_char_t *)yaml_malloc(size)
+
+/*
+ * Allocate and free the strings of tokens and events, which live in the
+ * parser arena if it is enabled (see yaml_parser_set_arena()).
+ */
+
+#define ARENA_MALLOC(parser,size)                                               \
+    ((parser)->arena ?                                                          \
+     (yaml_char_t *)yaml_arena_malloc((parser)->arena,(size)) :                 \
+     YAML_MALLOC(size))
+
+#define ARENA_FREE(parser,pointer)                                              \
+    ((parser)->arena ? (void)0 : yaml_free(pointer))
+
+/*
+ * Allocate and free the blocks of a document, which live in the document
+ * arena if it has one (see yaml_parser_set_document_arena()).
+ */
+
+#define DOCUMENT_MALLOC(document,size)                                          \
+    ((document)->arena ?                                                        \
+     yaml_arena_malloc((document)->arena,(size)) :                              \
+     yaml_malloc(size))
+
+#define DOCUMENT_FREE(document,pointer)                                         \
+    ((document)->arena ? (void)0 : yaml_free(pointer))
@@ -0,0 +1,552 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+/*
+ * Microbenchmarks of the scanner on generated inputs.
+ *
+ * Each case generates an input of about INPUT_SIZE octets in memory, scans it
+ * REPEAT times and reports the best throughput.  The "anchors" case loads
+ * documents with a growing number of anchors instead, and reports the best
+ * time per anchor for each size.  The "documents" case loads and deletes the
+ * "plain" input as a document, with the parser and document arenas, and as a
+ * compact document.  The "lookups" case looks up every key of mappings of a
+ * growing size.
+ */
+
+#define INPUT_SIZE  (16*1024*1024)
+#define REPEAT      5
+
+typedef struct {
+    char *start;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+static void
+append(buffer_t *buffer, const char *text)
+{
+    size_t length = strlen(text);
+
+    while (buffer->size + length + 1 > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity*2 : 65536;
+        buffer->start = (char *)realloc(buffer->start, buffer->capacity);
+        assert(buffer->start);
+    }
+
+    memcpy(buffer->start + buffer->size, text, length+1);
+    buffer->size += length;
+}
+
+static unsigned long seed = 1;
+
+static const char *
+word(void)
+{
+    static const char *words[] = {
+        "alpha", "beta", "gamma-delta", "epsilon_2", "zeta", "eta.theta",
+        "iota", "kappa/lambda", "mu", "nu42", "xi", "omicron", "pi-3.14",
+        "rho", "sigma", "tau", "upsilon", "phi", "chi", "psi", "omega"
+    };
+
+    seed = seed * 1103515245 + 12345;
+
+    return words[(seed >> 16) % (sizeof(words)/sizeof(*words))];
+}
+
+/*
+ * Block mappings and sequences of plain scalars.
+ */
+
+static void
+generate_plain(buffer_t *buffer)
+{
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "- name: "); append(buffer, word());
+        append(buffer, "\n  description: "); append(buffer, word());
+        append(buffer, " "); append(buffer, word());
+        append(buffer, " "); append(buffer, word());
+        append(buffer, "\n  tags:\n    - "); append(buffer, word());
+        append(buffer, "\n    - "); append(buffer, word());
+        append(buffer, "  # "); append(buffer, word());
+        append(buffer, "\n  count: 12345\n");
+    }
+}
+
+/*
+ * Flow collections of plain scalars.
+ */
+
+static void
+generate_flow(buffer_t *buffer)
+{
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "- [ "); append(buffer, word());
+        append(buffer, ", "); append(buffer, word());
+        append(buffer, ", { "); append(buffer, word());
+        append(buffer, ": "); append(buffer, word());
+        append(buffer, " "); append(buffer, word());
+        append(buffer, ", "); append(buffer, word());
+        append(buffer, ": 12345 } ]\n");
+    }
+}
+
+/*
+ * Single and double quoted scalars.
+ */
+
+static void
+generate_quoted(buffer_t *buffer)
+{
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "\""); append(buffer, word());
+        append(buffer, "\": '"); append(buffer, word());
+        append(buffer, " "); append(buffer, word());
+        append(buffer, " ''"); append(buffer, word());
+        append(buffer, "'''\n\""); append(buffer, word());
+        append(buffer, "-2\": \""); append(buffer, word());
+        append(buffer, "\\t"); append(buffer, word());
+        append(buffer, " \\u00e9"); append(buffer, word());
+        append(buffer, "\"\n");
+    }
+}
+
+/*
+ * A pretty-printed JSON array of records with numbers, booleans and nulls.
+ */
+
+static void
+generate_json(buffer_t *buffer)
+{
+    append(buffer, "[\n");
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "  {\n    \"id\": 12345,\n    \"name\": \"");
+        append(buffer, word());
+        append(buffer, "\",\n    \"active\": true,\n    \"score\": -1.5e3,\n"
+                "    \"parent\": null,\n    \"tags\": [\"");
+        append(buffer, word()); append(buffer, "\", \""); append(buffer, word());
+        append(buffer, "\"],\n    \"size\": {\"width\": 640, \"height\": 480}\n"
+                "  },\n");
+    }
+    append(buffer, "  {}\n]\n");
+}
+
+/*
+ * Literal and folded block scalars with long lines.
+ */
+
+static void
+generate_blocks(buffer_t *buffer)
+{
+    int k;
+
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "- script: |\n");
+        for (k = 0; k < 8; k ++) {
+            append(buffer, "    SELECT "); append(buffer, word());
+            append(buffer, ", "); append(buffer, word());
+            append(buffer, " FROM "); append(buffer, word());
+            append(buffer, " WHERE id = 12345 AND name <> '");
+            append(buffer, word()); append(buffer, "';\n");
+        }
+        append(buffer, "  certificate: >\n");
+        for (k = 0; k < 8; k ++) {
+            append(buffer, "    MIIBszCCAVmgAwIBAgIUX2Zu8BYr0WQkO5TSahx3Wg0d"
+                    "rMdUwCgYIKoZIzj0EAwIw\n");
+        }
+    }
+}
+
+/*
+ * JSON objects with long double quoted strings.
+ */
+
+static void
+generate_strings(buffer_t *buffer)
+{
+    int k;
+
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "{\""); append(buffer, word());
+        append(buffer, "\": \"");
+        for (k = 0; k < 30; k ++) {
+            append(buffer, word()); append(buffer, " ");
+        }
+        append(buffer, "\\\"end\\\"\", \"id\": \""); append(buffer, word());
+        append(buffer, "\"}\n");
+    }
+}
+
+/*
+ * Deeply indented block mappings with comments.
+ */
+
+static void
+generate_comments(buffer_t *buffer)
+{
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "# The "); append(buffer, word());
+        append(buffer, " resource, managed by the "); append(buffer, word());
+        append(buffer, " controller.\nspec:\n  template:\n    spec:\n"
+                "      containers:\n        - name: "); append(buffer, word());
+        append(buffer, "\n          # Pin the image to a released version.\n"
+                "          image: "); append(buffer, word());
+        append(buffer, "\n          resources:\n            limits:\n"
+                "              cpu: 500m    # half of a core\n"
+                "              memory: 128Mi\n");
+    }
+}
+
+/*
+ * Block mappings of short keys and values with tags, anchors and aliases.
+ */
+
+static void
+generate_mappings(buffer_t *buffer)
+{
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "? a\n: &x {b: 1, c: [2, 3]}\nd: !e f\ng:\n  h: *x\n"
+                "  i: 'j'\n  k: \"l\"\n  -m: n\n  o: p\n");
+    }
+}
+
+/*
+ * Deeply nested flow sequences.
+ */
+
+#define NESTING_DEPTH   500
+
+static void
+generate_nested(buffer_t *buffer)
+{
+    int k;
+
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "- ");
+        for (k = 0; k < NESTING_DEPTH; k ++) {
+            append(buffer, "["); append(buffer, word()); append(buffer, ", ");
+        }
+        for (k = 0; k < NESTING_DEPTH; k ++) {
+            append(buffer, "]");
+        }
+        append(buffer, "\n");
+    }
+}
+
+/*
+ * Block mappings with flow sequences of many tokens as keys.
+ */
+
+#define KEY_LENGTH  200
+
+static void
+generate_keys(buffer_t *buffer)
+{
+    int k;
+
+    while (buffer->size < INPUT_SIZE) {
+        append(buffer, "[");
+        for (k = 0; k < KEY_LENGTH; k ++) {
+            append(buffer, "[], ");
+        }
+        append(buffer, "]: "); append(buffer, word());
+        append(buffer, "\n");
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*generate)(buffer_t *buffer);
+} benchmark_t;
+
+static benchmark_t benchmarks[] = {
+    { "plain", generate_plain },
+    { "flow", generate_flow },
+    { "quoted", generate_quoted },
+    { "strings", generate_strings },
+    { "json", generate_json },
+    { "blocks", generate_blocks },
+    { "comments", generate_comments },
+    { "mappings", generate_mappings },
+    { "nested", generate_nested },
+    { "keys", generate_keys },
+    { NULL, NULL }
+};
+
+/*
+ * Scan the input and return the number of tokens.
+ */
+
+static long
+scan(const buffer_t *buffer)
+{
+    yaml_parser_t parser;
+    yaml_token_t token;
+    long count = 0;
+    int done = 0;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)buffer->start, buffer->size);
+
+    while (!done) {
+        assert(yaml_parser_scan(&parser, &token));
+        done = (token.type == YAML_STREAM_END_TOKEN);
+        yaml_token_delete(&token);
+        count ++;
+    }
+
+    yaml_parser_delete(&parser);
+
+    return count;
+}
+
+/*
+ * A block sequence of anchored scalars followed by aliases to them.
+ */
+
+static void
+generate_anchors(buffer_t *buffer, long count)
+{
+    char line[64];
+    long k;
+
+    for (k = 0; k < count; k ++) {
+        sprintf(line, "- &anchor%ld %ld\n", k, k);
+        append(buffer, line);
+    }
+    for (k = 0; k < count; k ++) {
+        sprintf(line, "- *anchor%ld\n", (k*7919) % count);
+        append(buffer, line);
+    }
+}
+
+/*
+ * Load the input into a document, an arena document or a compact document,
+ * and return the number of nodes.
+ */
+
+enum { HEAP_DOCUMENT, ARENA_DOCUMENT, COMPACT_DOCUMENT };
+
+static long
+load(const buffer_t *buffer, int mode)
+{
+    yaml_parser_t parser;
+    yaml_document_t document;
+    yaml_compact_document_t compact;
+    long count;
+
+    assert(yaml_parser_initialize(&parser));
+    yaml_parser_set_input_string(&parser,
+            (const unsigned char *)buffer->start, buffer->size);
+    if (mode == ARENA_DOCUMENT) {
+        yaml_parser_set_document_arena(&parser, 0);
+        assert(yaml_parser_set_arena(&parser, 0));
+    }
+
+    if (mode == COMPACT_DOCUMENT) {
+        assert(yaml_parser_load_compact(&parser, &compact, 0));
+        count = compact.count;
+        yaml_compact_document_delete(&compact);
+    }
+    else {
+        assert(yaml_parser_load(&parser, &document));
+        count = document.nodes.top - document.nodes.start;
+        yaml_document_delete(&document);
+    }
+
+    yaml_parser_delete(&parser);
+
+    return count;
+}
+
+/*
+ * Load documents of 1000 to 256000 anchors.
+ */
+
+static void
+benchmark_anchors(void)
+{
+    long count;
+
+    for (count = 1000; count <= 256000; count *= 4)
+    {
+        buffer_t buffer = { NULL, 0, 0 };
+        double best = 0;
+        int k;
+
+        generate_anchors(&buffer, count);
+
+        for (k = 0; k < REPEAT; k ++) {
+            clock_t start = clock();
+            double seconds;
+            assert(load(&buffer, HEAP_DOCUMENT) == count+1);
+            seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            if (!k || seconds < best)
+                best = seconds;
+        }
+
+        printf("%-10s %8.1f ns/anchor %7ld anchors\n", "anchors",
+                best * 1e9 / count, count);
+
+        free(buffer.start);
+    }
+}
+
+/*
+ * Load and delete a document, an arena document and a compact document.
+ */
+
+static void
+benchmark_documents(void)
+{
+    const char *names[] = { "heap-docs", "arena-docs", "compact" };
+    buffer_t buffer = { NULL, 0, 0 };
+    int mode;
+
+    generate_plain(&buffer);
+
+    for (mode = HEAP_DOCUMENT; mode <= COMPACT_DOCUMENT; mode ++)
+    {
+        double best = 0;
+        long count = 0;
+        int k;
+
+        for (k = 0; k < REPEAT; k ++) {
+            clock_t start = clock();
+            double seconds;
+            count = load(&buffer, mode);
+            seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            if (!k || seconds < best)
+                best = seconds;
+        }
+
+        printf("%-10s %8.1f MB/s %10ld nodes\n", names[mode],
+                buffer.size / 1e6 / (best > 0 ? best : 1e-9), count);
+    }
+
+    free(buffer.start);
+}
+
+/*
+ * Look up every key of mappings of 1000 to 256000 keys.
+ */
+
+static void
+benchmark_lookups(void)
+{
+    long count;
+
+    for (count = 1000; count <= 256000; count *= 4)
+    {
+        buffer_t buffer = { NULL, 0, 0 };
+        yaml_parser_t parser;
+        yaml_document_t document;
+        double best = 0;
+        char line[64];
+        long j;
+        int k;
+
+        for (j = 0; j < count; j ++) {
+            sprintf(line, "key%ld: %ld\n", j, j);
+            append(&buffer, line);
+        }
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)buffer.start, buffer.size);
+        assert(yaml_parser_load(&parser, &document));
+
+        for (k = 0; k < REPEAT; k ++) {
+            clock_t start = clock();
+            double seconds;
+            for (j = 0; j < count; j ++) {
+                sprintf(line, "key%ld", (j*7919) % count);
+                assert(yaml_document_mapping_get(&document, 1,
+                            (yaml_char_t *)line, -1));
+            }
+            seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            if (!k || seconds < best)
+                best = seconds;
+        }
+
+        printf("%-10s %8.1f ns/lookup %7ld keys\n", "lookups",
+                best * 1e9 / count, count);
+
+        yaml_document_delete(&document);
+        yaml_parser_delete(&parser);
+        free(buffer.start);
+    }
+}
+
+/*
+ * Check if a case is selected on the command line; all are by default.
+ */
+
+static int
+is_selected(int argc, char *argv[], const char *name)
+{
+    int k;
+
+    for (k = 1; k < argc; k ++) {
+        if (!strcmp(argv[k], name))
+            return 1;
+    }
+
+    return (argc < 2);
+}
+
+int
+main(int argc, char *argv[])
+{
+    benchmark_t *benchmark;
+
+    for (benchmark = benchmarks; benchmark->name; benchmark ++)
+    {
+        buffer_t buffer = { NULL, 0, 0 };
+        double best = 0;
+        long count = 0;
+        int k;
+
+        if (!is_selected(argc, argv, benchmark->name))
+            continue;
+
+        benchmark->generate(&buffer);
+
+        for (k = 0; k < REPEAT; k ++) {
+            clock_t start = clock();
+            double seconds;
+            count = scan(&buffer);
+            seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            if (!k || seconds < best)
+                best = seconds;
+        }
+
+        printf("%-10s %8.1f MB/s %10ld tokens\n", benchmark->name,
+                buffer.size / 1e6 / (best > 0 ? best : 1e-9), count);
+
+        free(buffer.start);
+    }
+
+    if (is_selected(argc, argv, "anchors")) {
+        benchmark_anchors();
+    }
+
+    if (is_selected(argc, argv, "documents")) {
+        benchmark_documents();
+    }
+
+    if (is_selected(argc, argv, "lookups")) {
+        benchmark_lookups();
+    }
+
+    return 0;
+}
@@ -0,0 +1,422 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+int check_anchors(void)
+{
+    char input[4000];
+    size_t length = 0;
+    int failed = 0;
+    int k;
+    printf("checking anchors...\n");
+    for (k = 0; k < 100; k++) {
+        length += sprintf(input+length, "- &a%d %d\n", k, k);
+    }
+    for (k = 0; k < 100; k++) {
+        length += sprintf(input+length, "- *a%d\n", (k*37) % 100);
+    }
+    for (k = 0; k < 3; k++) {
+        const char *tails[] = { "", "- &a42 x\n", "- *b\n" };
+        size_t lines[] = { 0, 200, 200 };
+        yaml_parser_t parser;
+        yaml_document_t document;
+        int loaded;
+        strcpy(input+length, tails[k]);
+        yaml_parser_initialize(&parser);
+        yaml_parser_set_input_string(&parser, (unsigned char *)input,
+                strlen(input));
+        loaded = yaml_parser_load(&parser, &document);
+        if (!k) {
+            int j;
+            for (j = 0; loaded && j < 100; j++) {
+                yaml_node_t *node = yaml_document_get_node(&document,
+                        document.nodes.start[0].data.sequence.items.start[100+j]);
+                if (atoi((char *)node->data.scalar.value) != (j*37) % 100)
+                    loaded = 0;
+            }
+            if (!loaded) {
+                printf("\t- the aliases are resolved wrongly\n");
+                failed++;
+            }
+            yaml_document_delete(&document);
+        }
+        else if (loaded || parser.error != YAML_COMPOSER_ERROR
+                || parser.problem_mark.line != lines[k]) {
+            printf("\t- the error #%d is not reported\n", k);
+            failed++;
+            if (loaded)
+                yaml_document_delete(&document);
+        }
+        yaml_parser_delete(&parser);
+    }
+    printf("checking anchors: %d fail(s)\n", failed);
+    return failed;
+}
+
+static int
+compare_documents(yaml_document_t *a, yaml_document_t *b)
+{
+    int k;
+    if (a->nodes.top - a->nodes.start != b->nodes.top - b->nodes.start
+            || !a->version_directive != !b->version_directive
+            || a->tag_directives.end - a->tag_directives.start
+                != b->tag_directives.end - b->tag_directives.start)
+        return 0;
+    for (k = 0; k < a->tag_directives.end - a->tag_directives.start; k++) {
+        if (strcmp((char *)a->tag_directives.start[k].prefix,
+                    (char *)b->tag_directives.start[k].prefix))
+            return 0;
+    }
+    for (k = 0; k < a->nodes.top - a->nodes.start; k++) {
+        yaml_node_t *x = a->nodes.start + k;
+        yaml_node_t *y = b->nodes.start + k;
+        if (x->type != y->type || strcmp((char *)x->tag, (char *)y->tag)
+                || x->end_mark.index != y->end_mark.index)
+            return 0;
+        if (x->type == YAML_SCALAR_NODE
+                && (x->data.scalar.length != y->data.scalar.length
+                    || memcmp(x->data.scalar.value, y->data.scalar.value,
+                        x->data.scalar.length+1)))
+            return 0;
+        if (x->type == YAML_SEQUENCE_NODE
+                && (x->data.sequence.items.top - x->data.sequence.items.start
+                    != y->data.sequence.items.top - y->data.sequence.items.start
+                    || (x->data.sequence.items.start
+                        != x->data.sequence.items.top
+                        && memcmp(x->data.sequence.items.start,
+                            y->data.sequence.items.start,
+                            (x->data.sequence.items.top
+                             - x->data.sequence.items.start)
+                            * sizeof(yaml_node_item_t)))))
+            return 0;
+        if (x->type == YAML_MAPPING_NODE
+                && (x->data.mapping.pairs.top - x->data.mapping.pairs.start
+                    != y->data.mapping.pairs.top - y->data.mapping.pairs.start
+                    || (x->data.mapping.pairs.start
+                        != x->data.mapping.pairs.top
+                        && memcmp(x->data.mapping.pairs.start,
+                            y->data.mapping.pairs.start,
+                            (x->data.mapping.pairs.top
+                             - x->data.mapping.pairs.start)
+                            * sizeof(yaml_node_pair_t)))))
+            return 0;
+    }
+    return 1;
+}
+
+int check_document_arena(void)
+{
+    yaml_parser_t parsers[2];
+    yaml_emitter_t emitters[2];
+    yaml_document_t documents[2];
+    unsigned char outputs[2][10000];
+    size_t written[2];
+    int failed = 0;
+    int done = 0;
+    int j;
+    unsigned char input[] = "%YAML 1.1\n%TAG !e! tag:e,2000:\n--- &a !e!x\n"
+        "key: [ 'one', \"two\", !!int 3, [], {} ]\n? |\n  block\n: *a\n"
+        "nested: {a: [b, {c: [d, e]}], f: g}\n"
+        "--- &b\n- !<tag:y> y\n- !\n- *b\n--- plain\n";
+    printf("checking document arenas...\n");
+    for (j = 0; j < 2; j++) {
+        yaml_parser_initialize(&parsers[j]);
+        yaml_parser_set_input_string(&parsers[j], input, sizeof(input)-1);
+        yaml_emitter_initialize(&emitters[j]);
+        yaml_emitter_set_output_string(&emitters[j], outputs[j],
+                sizeof(outputs[j]), &written[j]);
+    }
+    yaml_parser_set_document_arena(&parsers[1], 64);
+    yaml_parser_set_arena(&parsers[1], 64);
+    yaml_parser_set_zero_copy(&parsers[1], 1);
+    while (!done && !failed) {
+        for (j = 0; j < 2; j++) {
+            if (!yaml_parser_load(&parsers[j], &documents[j])) {
+                printf("\t- cannot load the input\n");
+                failed++;
+            }
+        }
+        if (failed)
+            break;
+        done = !yaml_document_get_root_node(&documents[0]);
+        if (!compare_documents(&documents[0], &documents[1])
+                || documents[0].arena || (!done && !documents[1].arena)) {
+            printf("\t- the documents differ\n");
+            failed++;
+        }
+        if (!done) {
+            int k, root;
+            for (k = 0; k < 2; k++) {
+                int scalar = yaml_document_add_scalar(&documents[k], NULL,
+                        (yaml_char_t *)"added", -1, YAML_ANY_SCALAR_STYLE);
+                int sequence = yaml_document_add_sequence(&documents[k], NULL,
+                        YAML_ANY_SEQUENCE_STYLE);
+                int mapping = yaml_document_add_mapping(&documents[k], NULL,
+                        YAML_ANY_MAPPING_STYLE);
+                int n;
+                root = 1;
+                for (n = 0; n < 40; n++) {
+                    yaml_document_append_sequence_item(&documents[k],
+                            sequence, scalar);
+                    yaml_document_append_mapping_pair(&documents[k],
+                            mapping, scalar, sequence);
+                }
+                if (documents[k].nodes.start[0].type == YAML_SEQUENCE_NODE)
+                    yaml_document_append_sequence_item(&documents[k],
+                            root, mapping);
+                if (documents[k].nodes.start[0].type == YAML_MAPPING_NODE)
+                    yaml_document_append_mapping_pair(&documents[k],
+                            root, scalar, mapping);
+            }
+            if (!compare_documents(&documents[0], &documents[1])) {
+                printf("\t- the extended documents differ\n");
+                failed++;
+            }
+        }
+        for (j = 0; j < 2; j++) {
+            if (!yaml_emitter_dump(&emitters[j], &documents[j])) {
+                printf("\t- cannot dump the document\n");
+                failed++;
+            }
+        }
+    }
+    if (!failed && (written[0] != written[1]
+                || memcmp(outputs[0], outputs[1], written[0]))) {
+        printf("\t- the dumped documents differ\n");
+        failed++;
+    }
+    for (j = 0; j < 2; j++) {
+        yaml_parser_delete(&parsers[j]);
+        yaml_emitter_delete(&emitters[j]);
+    }
+    printf("checking document arenas: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_mapping_get(void)
+{
+    char input[4000];
+    size_t length = 0;
+    int failed = 0;
+    int k;
+    printf("checking mapping lookups...\n");
+    for (k = 0; k < 100; k++) {
+        length += sprintf(input+length, "k%d: v%d\n", k, k);
+    }
+    strcpy(input+length, "k5: dup\n[k6]: seq\nsmall: {x: 1, y: 2}\n");
+    for (k = 0; k < 4; k++) {
+        yaml_parser_t parser;
+        yaml_document_t document;
+        yaml_node_t *node;
+        int j, key, value;
+        yaml_parser_initialize(&parser);
+        yaml_parser_set_input_string(&parser, (unsigned char *)input,
+                strlen(input));
+        if (k & 1)
+            yaml_parser_set_document_arena(&parser, 0);
+        if (!yaml_parser_load(&parser, &document)) {
+            printf("\t- cannot load the input\n");
+            failed++;
+            yaml_parser_delete(&parser);
+            continue;
+        }
+        if ((k & 2) && !yaml_document_build_indexes(&document)) {
+            printf("\t- cannot build the indexes\n");
+            failed++;
+        }
+        for (j = 0; j < 100; j++) {
+            char key[16], value[16];
+            sprintf(key, "k%d", j);
+            sprintf(value, "v%d", j);
+            node = yaml_document_mapping_get(&document, 1,
+                    (yaml_char_t *)key, -1);
+            if (!node || strcmp((char *)node->data.scalar.value, value)) {
+                printf("\t- the key %s is not found\n", key);
+                failed++;
+            }
+        }
+        node = yaml_document_mapping_get(&document, 1,
+                (yaml_char_t *)"small", 5);
+        if (yaml_document_mapping_get(&document, 1,
+                    (yaml_char_t *)"k100", -1)
+                || yaml_document_mapping_get(&document, 1,
+                    (yaml_char_t *)"[k6]", -1)
+                || !yaml_document_mapping_get(&document, 1,
+                    (yaml_char_t *)"k12345", 3)
+                || !node || node->type != YAML_MAPPING_NODE
+                || !yaml_document_mapping_get(&document,
+                    node - document.nodes.start + 1, (yaml_char_t *)"y", -1)
+                || yaml_document_mapping_get(&document,
+                    node - document.nodes.start + 1, (yaml_char_t *)"z", -1)) {
+            printf("\t- a wrong key is found\n");
+            failed++;
+        }
+        for (j = 0; j < 200; j++) {
+            char name[16];
+            sprintf(name, "new%d", j);
+            key = yaml_document_add_scalar(&document, NULL,
+                    (yaml_char_t *)name, -1, YAML_ANY_SCALAR_STYLE);
+            value = yaml_document_add_scalar(&document, NULL,
+                    (yaml_char_t *)"added", -1, YAML_ANY_SCALAR_STYLE);
+            yaml_document_append_mapping_pair(&document, 1, key, value);
+            node = yaml_document_mapping_get(&document, 1,
+                    (yaml_char_t *)name, -1);
+            if (node != document.nodes.start + value - 1
+                    || !yaml_document_mapping_get(&document, 1,
+                        (yaml_char_t *)"k99", -1)) {
+                printf("\t- the appended key %s is not found\n", name);
+                failed++;
+                break;
+            }
+        }
+        yaml_document_delete(&document);
+        yaml_parser_delete(&parser);
+    }
+    printf("checking mapping lookups: %d fail(s)\n", failed);
+    return failed;
+}
+
+static int
+compare_compact_document(yaml_document_t *a, yaml_compact_document_t *b)
+{
+    int k;
+    if (a->nodes.top - a->nodes.start != b->count
+            || !a->version_directive != !b->version_directive
+            || a->tag_directives.end - a->tag_directives.start
+                != b->tag_directives.end - b->tag_directives.start)
+        return 0;
+    for (k = 1; k <= b->count; k++) {
+        yaml_node_t *x = a->nodes.start + k-1;
+        yaml_mark_t start_mark, end_mark;
+        const int *children;
+        int count, j;
+        size_t length;
+        if (x->type != yaml_compact_node_type(b, k)
+                || strcmp((char *)x->tag, (char *)yaml_compact_node_tag(b, k)))
+            return 0;
+        if (yaml_compact_node_marks(b, k, &start_mark, &end_mark)
+                && (x->start_mark.index != start_mark.index
+                    || x->end_mark.index != end_mark.index))
+            return 0;
+        children = yaml_compact_node_children(b, k, &count);
+        switch (x->type) {
+            case YAML_SCALAR_NODE:
+                if ((int)x->data.scalar.style != yaml_compact_node_style(b, k)
+                        || memcmp(x->data.scalar.value,
+                            yaml_compact_node_value(b, k, &length),
+                            x->data.scalar.length+1)
+                        || x->data.scalar.length != length || count)
+                    return 0;
+                break;
+            case YAML_SEQUENCE_NODE:
+                if ((int)x->data.sequence.style != yaml_compact_node_style(b, k)
+                        || count != x->data.sequence.items.top
+                            - x->data.sequence.items.start)
+                    return 0;
+                for (j = 0; j < count; j++) {
+                    if (children[j] != x->data.sequence.items.start[j])
+                        return 0;
+                }
+                break;
+            case YAML_MAPPING_NODE:
+                if ((int)x->data.mapping.style != yaml_compact_node_style(b, k)
+                        || count != 2*(x->data.mapping.pairs.top
+                            - x->data.mapping.pairs.start))
+                    return 0;
+                for (j = 0; j < count/2; j++) {
+                    if (children[2*j] != x->data.mapping.pairs.start[j].key
+                            || children[2*j+1]
+                                != x->data.mapping.pairs.start[j].value)
+                        return 0;
+                }
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+int check_compact_documents(void)
+{
+    int failed = 0;
+    int k;
+    unsigned char input[] = "%YAML 1.1\n%TAG !e! tag:e,2000:\n--- &a !e!x\n"
+        "key: [ 'one', \"two\", !!int 3, [], {} ]\n? |\n  block\n: *a\n"
+        "nested: {a: [b, {c: [d, e]}], f: !e!x g}\n"
+        "--- &b\n- !<tag:y> y\n- !\n- *b\n--- plain\n";
+    printf("checking compact documents...\n");
+    for (k = 0; k < 4; k++) {
+        yaml_parser_t parsers[2];
+        yaml_document_t document;
+        yaml_compact_document_t compact;
+        int done = 0;
+        int j;
+        for (j = 0; j < 2; j++) {
+            yaml_parser_initialize(&parsers[j]);
+            yaml_parser_set_input_string(&parsers[j], input, sizeof(input)-1);
+        }
+        if (k & 2)
+            yaml_parser_set_zero_copy(&parsers[1], 1);
+        while (!done && !failed) {
+            if (!yaml_parser_load(&parsers[0], &document))
+                break;
+            if (!yaml_parser_load_compact(&parsers[1], &compact, k & 1)) {
+                printf("\t- cannot load the compact document\n");
+                failed++;
+                yaml_document_delete(&document);
+                break;
+            }
+            done = !compact.count;
+            if (!compare_compact_document(&document, &compact)) {
+                printf("\t- the compact document differs\n");
+                failed++;
+            }
+            for (j = 2; j <= compact.count; j++) {
+                if (!strcmp((char *)yaml_compact_node_tag(&compact, 1),
+                            (char *)yaml_compact_node_tag(&compact, j))
+                        && yaml_compact_node_tag(&compact, 1)
+                            != yaml_compact_node_tag(&compact, j)) {
+                    printf("\t- the tags are not interned\n");
+                    failed++;
+                }
+            }
+            yaml_document_delete(&document);
+            yaml_compact_document_delete(&compact);
+        }
+        for (j = 0; j < 2; j++) {
+            yaml_parser_delete(&parsers[j]);
+        }
+    }
+    for (k = 0; k < 2; k++) {
+        const char *inputs[] = { "- &a x\n- &a y\n", "- [1, {a: *b}]\n" };
+        yaml_parser_t parser;
+        yaml_compact_document_t compact;
+        yaml_parser_initialize(&parser);
+        yaml_parser_set_input_string(&parser,
+                (const unsigned char *)inputs[k], strlen(inputs[k]));
+        if (yaml_parser_load_compact(&parser, &compact, 1)
+                || parser.error != YAML_COMPOSER_ERROR) {
+            printf("\t- the error #%d is not reported\n", k);
+            failed++;
+            yaml_compact_document_delete(&compact);
+        }
+        yaml_parser_delete(&parser);
+    }
+    printf("checking compact documents: %d fail(s)\n", failed);
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_anchors() + check_document_arena() + check_mapping_get()
+        + check_compact_documents();
+}
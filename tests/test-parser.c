@@ -0,0 +1,385 @@
+#include <yaml.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+int check_zero_copy_scalars(void)
+{
+    yaml_parser_t parser;
+    yaml_event_t event;
+    int failed = 0;
+    int k = 0;
+    unsigned char input[] = "plain text: 'quoted ''one'''\n"
+        "\"a b\": \"a\\tb\"\nfolded: two\n  lines\n";
+    struct {
+        int offset;
+        int length;
+        const char *value;
+    } scalars[] = {
+        { 0, 10, NULL }, { 0, 0, "quoted 'one'" },
+        { 30, 3, NULL }, { 0, 0, "a\tb" },
+        { 43, 6, NULL }, { 0, 0, "two lines" }
+    };
+    printf("checking zero-copy scalars...\n");
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, input, sizeof(input)-1);
+    yaml_parser_set_zero_copy(&parser, 1);
+    while (!failed) {
+        if (!yaml_parser_parse(&parser, &event)) {
+            printf("\t- cannot parse the input\n");
+            failed++;
+            break;
+        }
+        if (event.type == YAML_SCALAR_EVENT) {
+            if (scalars[k].value
+                    ? (event.data.scalar.borrowed
+                        || strcmp((char *)event.data.scalar.value,
+                            scalars[k].value))
+                    : (!event.data.scalar.borrowed
+                        || event.data.scalar.value != input+scalars[k].offset
+                        || event.data.scalar.length
+                            != (size_t)scalars[k].length)) {
+                printf("\t- the scalar #%d is wrong\n", k);
+                failed++;
+            }
+            k++;
+        }
+        if (event.type == YAML_STREAM_END_EVENT) {
+            yaml_event_delete(&event);
+            break;
+        }
+        yaml_event_delete(&event);
+    }
+    yaml_parser_delete(&parser);
+    printf("checking zero-copy scalars: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_marks(void)
+{
+    yaml_parser_t parser;
+    yaml_token_t token;
+    int failed = 0;
+    int k = 0;
+    unsigned char input[] = "k\xc3\xa9y: a\r\n"
+        "x: \"b\xc2\x85 c\" # \xe4\xb8\xad\n- d\n";
+    size_t marks[][6] = {
+        { 0, 0, 0, 3, 0, 3 }, { 5, 0, 5, 6, 0, 6 }, { 8, 1, 0, 9, 1, 1 },
+        { 11, 1, 3, 17, 2, 3 }, { 24, 3, 2, 25, 3, 3 }
+    };
+    printf("checking marks...\n");
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, input, sizeof(input)-1);
+    while (!failed) {
+        if (!yaml_parser_scan(&parser, &token)) {
+            printf("\t- cannot scan the input\n");
+            failed++;
+            break;
+        }
+        if (token.type == YAML_SCALAR_TOKEN) {
+            if (token.start_mark.index != marks[k][0]
+                    || token.start_mark.line != marks[k][1]
+                    || token.start_mark.column != marks[k][2]
+                    || token.end_mark.index != marks[k][3]
+                    || token.end_mark.line != marks[k][4]
+                    || token.end_mark.column != marks[k][5]) {
+                printf("\t- the marks of the scalar #%d are wrong\n", k);
+                failed++;
+            }
+            k++;
+        }
+        if (token.type == YAML_STREAM_END_TOKEN) {
+            yaml_token_delete(&token);
+            break;
+        }
+        yaml_token_delete(&token);
+    }
+    yaml_parser_delete(&parser);
+    printf("checking marks: %d fail(s)\n", failed);
+    return failed;
+}
+
+typedef struct {
+    const unsigned char *start;
+    size_t size;
+} chunked_input_t;
+
+static int chunked_read_handler(void *data, unsigned char *buffer,
+        size_t size, size_t *size_read)
+{
+    chunked_input_t *input = (chunked_input_t *)data;
+    if (size > 3)
+        size = 3;
+    if (size > input->size)
+        size = input->size;
+    memcpy(buffer, input->start, size);
+    input->start += size;
+    input->size -= size;
+    *size_read = size;
+    return 1;
+}
+
+/*
+ * Scan or parse an input with and without the JSON mode, from a string or
+ * in chunks of 3 octets, and check that the tokens or the events and the
+ * errors are the same.
+ */
+
+static int
+compare_json_mode(const char *input, int chunked, int parse)
+{
+    yaml_parser_t parsers[2];
+    chunked_input_t inputs[2];
+    int same = 1;
+    int done = 0;
+    int j;
+    for (j = 0; j < 2; j++) {
+        yaml_parser_initialize(&parsers[j]);
+        yaml_parser_set_json_mode(&parsers[j], j);
+        inputs[j].start = (const unsigned char *)input;
+        inputs[j].size = strlen(input);
+        if (chunked)
+            yaml_parser_set_input(&parsers[j], chunked_read_handler,
+                    &inputs[j]);
+        else
+            yaml_parser_set_input_string(&parsers[j], inputs[j].start,
+                    inputs[j].size);
+    }
+    while (same && !done) {
+        yaml_token_t tokens[2];
+        yaml_event_t events[2];
+        int results[2];
+        int types[2];
+        yaml_mark_t starts[2], ends[2];
+        const yaml_char_t *values[2];
+        size_t lengths[2];
+        int styles[2];
+        for (j = 0; j < 2; j++) {
+            values[j] = NULL;
+            lengths[j] = 0;
+            styles[j] = 0;
+            if (parse) {
+                results[j] = yaml_parser_parse(&parsers[j], &events[j]);
+                types[j] = events[j].type;
+                starts[j] = events[j].start_mark;
+                ends[j] = events[j].end_mark;
+                if (results[j] && events[j].type == YAML_SCALAR_EVENT) {
+                    values[j] = events[j].data.scalar.value;
+                    lengths[j] = events[j].data.scalar.length;
+                    styles[j] = events[j].data.scalar.style;
+                }
+            }
+            else {
+                results[j] = yaml_parser_scan(&parsers[j], &tokens[j]);
+                types[j] = tokens[j].type;
+                starts[j] = tokens[j].start_mark;
+                ends[j] = tokens[j].end_mark;
+                if (results[j] && tokens[j].type == YAML_SCALAR_TOKEN) {
+                    values[j] = tokens[j].data.scalar.value;
+                    lengths[j] = tokens[j].data.scalar.length;
+                    styles[j] = tokens[j].data.scalar.style;
+                }
+            }
+        }
+        if (results[0] != results[1] || types[0] != types[1]
+                || starts[0].index != starts[1].index
+                || ends[0].index != ends[1].index
+                || lengths[0] != lengths[1] || styles[0] != styles[1]
+                || (lengths[0] && memcmp(values[0], values[1], lengths[0]))
+                || parsers[0].error != parsers[1].error
+                || parsers[0].problem_offset != parsers[1].problem_offset
+                || parsers[0].problem_mark.index
+                    != parsers[1].problem_mark.index)
+            same = 0;
+        done = (!results[0] || types[0] == (parse ? YAML_STREAM_END_EVENT
+                    : YAML_STREAM_END_TOKEN));
+        for (j = 0; j < 2; j++) {
+            if (parse)
+                yaml_event_delete(&events[j]);
+            else
+                yaml_token_delete(&tokens[j]);
+        }
+    }
+    for (j = 0; j < 2; j++) {
+        yaml_parser_delete(&parsers[j]);
+    }
+    return same;
+}
+
+int check_json_mode(void)
+{
+    char long_key[1030];
+    const char *inputs[] = {
+        "{\"a\": 1, \"b\": [true, false, null, -1.5e3], \"c\": {}}",
+        "{\n  \"a\" : \"x\",\n  \"b\": [\n    1,\n    2\n  ]\n}\n",
+        "[{\"a\": 1}, {\"b\": 2}: 3, \"c\" x: 4, \"d\"\n: 5]",
+        "[\"a\" # c\n, \"b\"\t:\t\"c\"\n d\": e, 1 2, 1\n, \"f\"",
+        "{a: [1, 2], ? b, --- , ...: x}\n- \"k\": v",
+        "[1, \"a\\tb\", {\"c\": [true]},\r\n {\"d\": null} @, 2]",
+        "{\"x\": [\n  \"a\"\n>]}",
+        "{\"n\": 1,\n  \"c_compiler\": \"gcc\",\n\xff",
+        long_key,
+        NULL
+    };
+    int failed = 0;
+    int k;
+    printf("checking the JSON mode...\n");
+    memset(long_key, 'x', sizeof(long_key));
+    memcpy(long_key, "{\"", 2);
+    memcpy(long_key+1024, "\": 1}", 6);
+    for (k = 0; inputs[k]; k++) {
+        int mode;
+        for (mode = 0; mode < 4; mode++) {
+            if (!compare_json_mode(inputs[k], mode & 1, mode & 2)) {
+                printf("\t- the %s of the input #%d differ%s\n",
+                        (mode & 2) ? "events" : "tokens", k,
+                        (mode & 1) ? " in chunks" : "");
+                failed++;
+            }
+        }
+    }
+    printf("checking the JSON mode: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_parse_batch(void)
+{
+    yaml_parser_t pulled, batched;
+    yaml_event_t expected, events[3];
+    int failed = 0;
+    int done = 0;
+    unsigned char input[] = "--- [a, b, {c: d}]\n--- e\n...\n---\n"
+        "- &f g\n- *f\n";
+    printf("checking batches of events...\n");
+    yaml_parser_initialize(&pulled);
+    yaml_parser_initialize(&batched);
+    yaml_parser_set_input_string(&pulled, input, sizeof(input)-1);
+    yaml_parser_set_input_string(&batched, input, sizeof(input)-1);
+    while (!done && !failed) {
+        size_t count, k;
+        if (!yaml_parser_parse_batch(&batched, events, 3, &count, 1)
+                || !count) {
+            printf("\t- cannot parse the input\n");
+            failed++;
+            break;
+        }
+        for (k = 0; k < count; k++) {
+            if (!yaml_parser_parse(&pulled, &expected)
+                    || events[k].type != expected.type
+                    || events[k].start_mark.index != expected.start_mark.index
+                    || events[k].end_mark.index != expected.end_mark.index
+                    || (events[k].type == YAML_DOCUMENT_END_EVENT
+                        && k+1 != count)
+                    || (count < 3 && k+1 == count
+                        && events[k].type != YAML_DOCUMENT_END_EVENT
+                        && events[k].type != YAML_STREAM_END_EVENT)) {
+                printf("\t- the event #%d of a batch differs\n", (int)k);
+                failed++;
+            }
+            done = (expected.type == YAML_STREAM_END_EVENT);
+            yaml_event_delete(&expected);
+            yaml_event_delete(&events[k]);
+        }
+    }
+    if (!failed) {
+        size_t count;
+        if (!yaml_parser_parse_batch(&batched, events, 3, &count, 0)
+                || count) {
+            printf("\t- events are produced after the end of the stream\n");
+            failed++;
+        }
+    }
+    yaml_parser_delete(&pulled);
+    yaml_parser_delete(&batched);
+    printf("checking batches of events: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_arena(void)
+{
+    yaml_parser_t parsers[2];
+    yaml_event_t events[2];
+    int failed = 0;
+    int done = 0;
+    int j;
+    unsigned char input[] = "%TAG !e! tag:e,2000:\n--- &a !e!x\n"
+        "key: [ 'one', \"two\", !!int 3 ]\n? |\n  block\n: *a\n"
+        "--- &b\n- !<tag:y> y\n- !\n- *b\n";
+    printf("checking arena strings...\n");
+    for (j = 0; j < 2; j++) {
+        yaml_parser_initialize(&parsers[j]);
+        yaml_parser_set_input_string(&parsers[j], input, sizeof(input)-1);
+    }
+    yaml_parser_set_arena(&parsers[1], 64);
+    while (!done && !failed) {
+        yaml_char_t *strings[2][3];
+        int k;
+        for (j = 0; j < 2; j++) {
+            if (!yaml_parser_parse(&parsers[j], &events[j])) {
+                printf("\t- cannot parse the input\n");
+                failed++;
+                break;
+            }
+            memset(strings[j], 0, sizeof(strings[j]));
+            switch (events[j].type) {
+                case YAML_ALIAS_EVENT:
+                    strings[j][0] = events[j].data.alias.anchor;
+                    break;
+                case YAML_SCALAR_EVENT:
+                    strings[j][0] = events[j].data.scalar.anchor;
+                    strings[j][1] = events[j].data.scalar.tag;
+                    strings[j][2] = events[j].data.scalar.value;
+                    break;
+                case YAML_SEQUENCE_START_EVENT:
+                    strings[j][0] = events[j].data.sequence_start.anchor;
+                    strings[j][1] = events[j].data.sequence_start.tag;
+                    break;
+                case YAML_MAPPING_START_EVENT:
+                    strings[j][0] = events[j].data.mapping_start.anchor;
+                    strings[j][1] = events[j].data.mapping_start.tag;
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (failed)
+            break;
+        for (k = 0; k < 3; k++) {
+            if (!strings[0][k] != !strings[1][k] || (strings[0][k]
+                        && strcmp((char *)strings[0][k],
+                            (char *)strings[1][k]))) {
+                failed++;
+            }
+        }
+        if (events[0].type != events[1].type
+                || events[0].arena || !events[1].arena) {
+            failed++;
+        }
+        if (failed) {
+            printf("\t- the event of the type %d differs\n",
+                    (int)events[0].type);
+        }
+        done = (events[0].type == YAML_STREAM_END_EVENT);
+        for (j = 0; j < 2; j++) {
+            yaml_event_delete(&events[j]);
+        }
+    }
+    for (j = 0; j < 2; j++) {
+        yaml_parser_delete(&parsers[j]);
+    }
+    printf("checking arena strings: %d fail(s)\n", failed);
+    return failed;
+}
+
+int
+main(void)
+{
+    return check_zero_copy_scalars() + check_marks() + check_json_mode()
+        + check_parse_batch() + check_arena();
+}
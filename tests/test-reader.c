@@ -5,6 +5,7 @@ yaml_parser_update_buffer(yaml_parser_t *parser, size_t length);
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #ifdef NDEBUG
 #undef NDEBUG
@@ -347,8 +348,335 @@ int check_long_utf16(void)
     return failed;
 }
 
+int check_invalid_octet_offsets(void)
+{
+    yaml_parser_t parser;
+    size_t positions[] = { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 1000,
+        16383, 16384, 16385, LONG-1 };
+    unsigned char octets[] = { '\x01', '\x7f', '\x80', '\xff' };
+    size_t p, o, k;
+    int failed = 0;
+    unsigned char *buffer = (unsigned char *)malloc(LONG);
+    assert(buffer);
+    printf("checking offsets of invalid octets...\n");
+    for (p = 0; p < sizeof(positions)/sizeof(*positions); p++) {
+        for (o = 0; o < sizeof(octets); o++) {
+            int result = 1;
+            for (k = 0; k < LONG; k++) {
+                buffer[k] = (k % 40 == 39) ? '\n' : 'a' + (k % 26);
+            }
+            buffer[positions[p]] = octets[o];
+            yaml_parser_initialize(&parser);
+            yaml_parser_set_input_string(&parser, buffer, LONG);
+            while (result && !(parser.eof
+                        && parser.raw_buffer.pointer == parser.raw_buffer.last)) {
+                result = yaml_parser_update_buffer(&parser, 1);
+                parser.buffer.pointer = parser.buffer.last;
+                parser.unread = 0;
+            }
+            if (result || parser.problem_offset != positions[p]
+                    || parser.problem_value != octets[o]) {
+                printf("\t- #%X at %ld: ", (int)octets[o], (long)positions[p]);
+                if (result) {
+                    printf("no error\n");
+                }
+                else {
+                    printf("%s: #%X at %ld\n", parser.problem,
+                            parser.problem_value, (long)parser.problem_offset);
+                }
+                failed++;
+            }
+            yaml_parser_delete(&parser);
+        }
+    }
+    free(buffer);
+    printf("checking offsets of invalid octets: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_invalid_utf16_offsets(void)
+{
+    yaml_parser_t parser;
+    size_t positions[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 1000,
+        8191, 8192, 8193, LONG/2-1 };
+    unsigned int units[] = { 0x01, 0x7F, 0xDC00, 0xFFFE };
+    size_t p, u, k;
+    int big_endian;
+    int failed = 0;
+    unsigned char *buffer = (unsigned char *)malloc(2+LONG);
+    assert(buffer);
+    printf("checking offsets of invalid utf16 characters...\n");
+    for (big_endian = 0; big_endian < 2; big_endian++) {
+        for (p = 0; p < sizeof(positions)/sizeof(*positions); p++) {
+            for (u = 0; u < sizeof(units)/sizeof(*units); u++) {
+                int result = 1;
+                for (k = 0; k < LONG/2; k++) {
+                    unsigned int unit = (k == positions[p]) ? units[u] :
+                        (k % 40 == 39) ? '\n' : 'a' + (k % 26);
+                    buffer[2+k*2+big_endian] = unit & 0xFF;
+                    buffer[2+k*2+1-big_endian] = unit >> 8;
+                }
+                buffer[big_endian] = '\xff';
+                buffer[1-big_endian] = '\xfe';
+                yaml_parser_initialize(&parser);
+                yaml_parser_set_input_string(&parser, buffer, 2+LONG/2*2);
+                while (result && !(parser.eof
+                            && parser.raw_buffer.pointer == parser.raw_buffer.last)) {
+                    result = yaml_parser_update_buffer(&parser, 1);
+                    parser.buffer.pointer = parser.buffer.last;
+                    parser.unread = 0;
+                }
+                if (result || parser.problem_offset != 2+positions[p]*2
+                        || parser.problem_value != (int)units[u]) {
+                    printf("\t- #%X at %ld (%s): ", units[u], (long)positions[p],
+                            big_endian ? "BE" : "LE");
+                    if (result) {
+                        printf("no error\n");
+                    }
+                    else {
+                        printf("%s: #%X at %ld\n", parser.problem,
+                                parser.problem_value, (long)parser.problem_offset);
+                    }
+                    failed++;
+                }
+                yaml_parser_delete(&parser);
+            }
+        }
+    }
+    free(buffer);
+    printf("checking offsets of invalid utf16 characters: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_borrowed_string(void)
+{
+    yaml_parser_t parser;
+    int failed = 0;
+    unsigned char valid[] = "\xef\xbb\xbfkey: \xd0\x9f\xd1\x80\xd0\xb8";
+    unsigned char invalid[] = "key: \xd0value";
+    printf("checking borrowed string inputs...\n");
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, valid, sizeof(valid)-1);
+    if (!yaml_parser_update_buffer(&parser, 1)
+            || parser.buffer.pointer != valid+3 || parser.unread != 8) {
+        printf("\t- the valid input is not borrowed\n");
+        failed++;
+    }
+    parser.buffer.pointer = parser.buffer.last;
+    parser.unread = 0;
+    if (!yaml_parser_update_buffer(&parser, 1)
+            || parser.unread != 1 || parser.buffer.pointer[0] != '\0') {
+        printf("\t- no NUL at the end of the borrowed input\n");
+        failed++;
+    }
+    yaml_parser_delete(&parser);
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, invalid, sizeof(invalid)-1);
+    if (yaml_parser_update_buffer(&parser, 1) || parser.problem_offset != 6) {
+        printf("\t- the invalid input is not reported at 6\n");
+        failed++;
+    }
+    yaml_parser_delete(&parser);
+    printf("checking borrowed string inputs: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_mmap_input(void)
+{
+#if defined(_WIN32)
+    return 0;
+#else
+    yaml_parser_t parser;
+    FILE *file = tmpfile();
+    unsigned char *buffer;
+    int failed = 0;
+    size_t k, count = 0, offset;
+    printf("checking memory-mapped inputs...\n");
+    assert(file);
+    for (k = 0; k < LONG; k++) {
+        fputs("key: \xd0\x9f\xd1\x80\xd0\xb8\n", file);
+    }
+    fflush(file);
+    yaml_parser_initialize(&parser);
+    if (!yaml_parser_set_input_mmap(&parser, fileno(file))) {
+        printf("\t- cannot map the input: %s\n", parser.problem);
+        yaml_parser_delete(&parser);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    if (!yaml_parser_update_buffer(&parser, 1)
+            || parser.buffer.pointer != parser.mapping.start) {
+        printf("\t- the mapping is not scanned in place\n");
+        failed++;
+    }
+    while (yaml_parser_update_buffer(&parser, 4) && parser.buffer.pointer[0]) {
+        unsigned char octet = parser.buffer.pointer[0];
+        parser.buffer.pointer += (octet & 0x80) == 0x00 ? 1 :
+                                 (octet & 0xE0) == 0xC0 ? 2 :
+                                 (octet & 0xF0) == 0xE0 ? 3 : 4;
+        parser.unread--;
+        count++;
+    }
+    if (parser.error || count != LONG*9) {
+        printf("\t- read %d characters instead of %d\n", (int)count, LONG*9);
+        failed++;
+    }
+    yaml_parser_delete(&parser);
+    buffer = (unsigned char *)malloc(3+LONG*12+2);
+    assert(buffer);
+    memcpy(buffer, "\xef\xbb\xbf", 3);
+    for (k = 0; k < LONG; k++) {
+        memcpy(buffer+3+k*12, "key: \xd0\x9f\xd1\x80\xd0\xb8\n", 12);
+    }
+    memcpy(buffer+3+LONG*12, "\xd0\xff", 2);
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, buffer, 3+LONG*12+2);
+    while (yaml_parser_update_buffer(&parser, 4) && parser.buffer.pointer[0]) {
+        parser.buffer.pointer = parser.buffer.last;
+        parser.unread = 0;
+    }
+    offset = parser.problem_offset;
+    yaml_parser_delete(&parser);
+    file = tmpfile();
+    assert(file);
+    fwrite(buffer, 1, 3+LONG*12+2, file);
+    fflush(file);
+    free(buffer);
+    yaml_parser_initialize(&parser);
+    if (!yaml_parser_set_input_mmap(&parser, fileno(file))) {
+        printf("\t- cannot map the input: %s\n", parser.problem);
+        yaml_parser_delete(&parser);
+        fclose(file);
+        return failed+1;
+    }
+    fclose(file);
+    if (!yaml_parser_update_buffer(&parser, 4)
+            || parser.buffer.pointer != parser.mapping.start+3) {
+        printf("\t- the valid head of the mapping is not scanned in place\n");
+        failed++;
+    }
+    while (yaml_parser_update_buffer(&parser, 4) && parser.buffer.pointer[0]) {
+        parser.buffer.pointer = parser.buffer.last;
+        parser.unread = 0;
+    }
+    if (parser.error != YAML_READER_ERROR || offset < 3+LONG*12
+            || parser.problem_offset != offset) {
+        printf("\t- an invalid octet is reported at %ld instead of %ld\n",
+                (long)parser.problem_offset, (long)offset);
+        failed++;
+    }
+    yaml_parser_delete(&parser);
+    printf("checking memory-mapped inputs: %d fail(s)\n", failed);
+    return failed;
+#endif
+}
+
+static size_t failing_offset;
+
+static int failing_read_handler(void *data, unsigned char *buffer, size_t size,
+        size_t *size_read)
+{
+    size_t *offset = (size_t *)data;
+    if (*offset >= failing_offset)
+        return 0;
+    if (size > 3)
+        size = 3;
+    if (size > failing_offset - *offset)
+        size = failing_offset - *offset;
+    memset(buffer, 'a' + *offset % 26, size);
+    *offset += size;
+    *size_read = size;
+    return 1;
+}
+
+static size_t read_all(int read_ahead, size_t *problem_offset)
+{
+    yaml_parser_t parser;
+    size_t offset = 0;
+    size_t count = 0;
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input(&parser, failing_read_handler, &offset);
+    if (read_ahead && !yaml_parser_set_read_ahead(&parser, 2, 5)) {
+        yaml_parser_delete(&parser);
+        return 0;
+    }
+    while (yaml_parser_update_buffer(&parser, 2)) {
+        parser.buffer.pointer ++;
+        parser.unread --;
+        count ++;
+    }
+    *problem_offset = parser.problem_offset;
+    yaml_parser_delete(&parser);
+    return count;
+}
+
+int check_read_ahead(void)
+{
+    int failed = 0;
+    size_t pulled, ahead, pulled_offset, ahead_offset;
+    printf("checking read-ahead inputs...\n");
+    failing_offset = 10007;
+    pulled = read_all(0, &pulled_offset);
+    ahead = read_all(1, &ahead_offset);
+    if (pulled != ahead || pulled_offset != ahead_offset) {
+        printf("\t- read %d characters up to %d instead of %d up to %d\n",
+                (int)ahead, (int)ahead_offset, (int)pulled, (int)pulled_offset);
+        failed++;
+    }
+    printf("checking read-ahead inputs: %d fail(s)\n", failed);
+    return failed;
+}
+
+int check_pushed_input(void)
+{
+    yaml_parser_t pulled, pushed;
+    yaml_event_t expected, event;
+    int failed = 0;
+    size_t k = 0;
+    unsigned char input[] = "%TAG !e! tag:e,2000:\n--- &a !e!x\n"
+        "key: [ 'one', \"two\" ]\n? |\n  block\n: *a\n...\n";
+    printf("checking pushed inputs...\n");
+    yaml_parser_initialize(&pulled);
+    yaml_parser_initialize(&pushed);
+    yaml_parser_set_input_string(&pulled, input, sizeof(input)-1);
+    yaml_parser_feed(&pushed, input, 0, 0);
+    while (!failed) {
+        int result = yaml_parser_parse(&pushed, &event);
+        if (result == YAML_PARSER_NEED_MORE_INPUT && k < sizeof(input)-1) {
+            yaml_parser_feed(&pushed, input+k, 1, k+1 == sizeof(input)-1);
+            k++;
+            continue;
+        }
+        if (result != 1 || !yaml_parser_parse(&pulled, &expected)) {
+            printf("\t- cannot parse the input at %d\n", (int)k);
+            failed++;
+            break;
+        }
+        if (event.type != expected.type
+                || event.start_mark.index != expected.start_mark.index
+                || event.end_mark.index != expected.end_mark.index) {
+            printf("\t- the event at %d differs\n", (int)k);
+            failed++;
+        }
+        yaml_event_delete(&event);
+        if (expected.type == YAML_STREAM_END_EVENT) {
+            yaml_event_delete(&expected);
+            break;
+        }
+        yaml_event_delete(&expected);
+    }
+    yaml_parser_delete(&pulled);
+    yaml_parser_delete(&pushed);
+    printf("checking pushed inputs: %d fail(s)\n", failed);
+    return failed;
+}
+
 int
 main(void)
 {
-    return check_utf8_sequences() + check_boms() + check_long_utf8() + check_long_utf16();
+    return check_utf8_sequences() + check_boms() + check_long_utf8() + check_long_utf16()
+        + check_invalid_octet_offsets() + check_invalid_utf16_offsets()
+        + check_borrowed_string() + check_mmap_input()
+        + check_pushed_input() + check_read_ahead();
 }